@@ -0,0 +1,127 @@
+#include "Cache.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+// goes into every key, bump it whenever the same source and options start producing different output
+static const char * compilerversion = "mila 1 / LLVM " LLVM_VERSION_STRING;
+
+string compilecache::key( StringRef source, StringRef options )
+{
+  SHA1 hash;
+  // every part is preceded by its length so no two different inputs hash the same bytes
+  for( StringRef part : { StringRef(compilerversion), options, source } )
+  {
+    hash.update(to_string(part.size()));
+    hash.update(":");
+    hash.update(part);
+  }
+  return toHex(hash.final(), true);
+}
+
+// Entries are spread over 256 subdirectories by the first two digits of their key
+string compilecache::entrypath( const string & key ) const
+{
+  SmallString<128> path(directory);
+  sys::path::append(path, key.substr(0, 2), key.substr(2));
+  return string(path.str());
+}
+
+unique_ptr< MemoryBuffer > compilecache::lookup( const string & key ) const
+{
+  auto buffer = MemoryBuffer::getFile(entrypath(key));
+  if( !buffer )
+  { return nullptr; }
+  return move(*buffer);
+}
+
+bool compilecache::store( const string & key, StringRef output ) const
+{
+  string path = entrypath(key);
+  if( sys::fs::create_directories(sys::path::parent_path(path)) )
+  { return false; }
+
+  // a unique temporary next to the entry, renaming it is atomic within the one file system
+  int fd;
+  SmallString<128> temporary;
+  if( sys::fs::createUniqueFile(path + ".tmp-%%%%%%%%", fd, temporary) )
+  { return false; }
+  {
+    raw_fd_ostream out(fd, true);
+    out << output;
+    out.close();
+    if( out.has_error() )
+    {
+      out.clear_error();
+      sys::fs::remove(temporary);
+      return false;
+    }
+  }
+  if( sys::fs::rename(temporary, path) )
+  {
+    sys::fs::remove(temporary);
+    return false;
+  }
+  return true;
+}
+
+// The statistics are the two counters "<hits> <misses>" in the file stats, read and rewritten under an exclusive
+// lock so concurrent compilers never lose a count. A file not in this form counts from zero again
+static string statspath( const string & directory )
+{
+  SmallString<128> path(directory);
+  sys::path::append(path, "stats");
+  return string(path.str());
+}
+
+static void readstats( int fd, unsigned long long & hits, unsigned long long & misses )
+{
+  char text[64];
+  ssize_t size = pread(fd, text, sizeof(text) - 1, 0);
+  text[size > 0 ? size : 0] = '\0';
+  if( sscanf(text, "%llu %llu", &hits, &misses) != 2 )
+  { hits = misses = 0; }
+}
+
+void compilecache::record( bool hit ) const
+{
+  if( sys::fs::create_directories(directory) )
+  { return; }
+  int fd = open(statspath(directory).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if( fd < 0 )
+  { return; }
+  if( flock(fd, LOCK_EX) == 0 )
+  {
+    unsigned long long hits, misses;
+    readstats(fd, hits, misses);
+    ( hit ? hits : misses )++;
+    char text[64];
+    int size = snprintf(text, sizeof(text), "%llu %llu\n", hits, misses);
+    if( pwrite(fd, text, size, 0) == size )
+    { ftruncate(fd, size); }
+  }
+  // closing drops the lock
+  close(fd);
+}
+
+void compilecache::printstats( FILE * out ) const
+{
+  unsigned long long hits = 0, misses = 0;
+  int fd = open(statspath(directory).c_str(), O_RDONLY | O_CLOEXEC);
+  if( fd >= 0 )
+  {
+    if( flock(fd, LOCK_SH) == 0 )
+    { readstats(fd, hits, misses); }
+    close(fd);
+  }
+  unsigned long long total = hits + misses;
+  fprintf(out, "cache: %llu hits, %llu misses, %.1f%% hit rate in %s\n",
+          hits, misses, total ? 100.0 * hits / total : 0.0, directory.c_str());
+}
@@ -0,0 +1,41 @@
+#ifndef PJPPROJECT_CACHE_HPP
+#define PJPPROJECT_CACHE_HPP
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace llvm;
+using namespace std;
+
+// " COMPILATION CACHE " ( --cache-dir ) keeps finished outputs in a directory, each one named by the hash of
+// the source and of everything else that shapes it. Entries are written to a temporary file and renamed into
+// place so any number of compilers can share the directory, a reader sees either a whole entry or none
+class compilecache
+{
+private:
+  string directory;
+
+  string entrypath( const string & key ) const;
+
+public:
+  // " CONSTRUCTOR "
+  explicit compilecache( string directory ) : directory(move(directory)) {}
+
+  // SHA-1 of the compiler's version, the ( options ) and the ( source ) as 40 hex digits
+  static string key( StringRef source, StringRef options );
+
+  // The output stored under ( key ) or nullptr on a miss
+  unique_ptr< MemoryBuffer > lookup( const string & key ) const;
+  // Stores ( output ) under ( key ), returns false if the directory couldn't be written
+  bool store( const string & key, StringRef output ) const;
+
+  // Counts a hit or a miss in the statistics of the directory
+  void record( bool hit ) const;
+  // Prints the hits and misses every compiler using the directory recorded
+  void printstats( FILE * out ) const;
+};
+
+#endif //PJPPROJECT_CACHE_HPP
@@ -0,0 +1,239 @@
+#include "Client.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Source.hpp"
+
+bool sendall( int fd, const char * data, size_t size )
+{
+  while( size > 0 )
+  {
+    ssize_t sent = write(fd, data, size);
+    if( sent < 0 && errno == EINTR )
+    { continue; }
+    if( sent <= 0 )
+    { return false; }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+bool receiveall( int fd, char * data, size_t size )
+{
+  while( size > 0 )
+  {
+    ssize_t received = read(fd, data, size);
+    if( received < 0 && errno == EINTR )
+    { continue; }
+    if( received <= 0 )
+    { return false; }
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+bool sendnumber( int fd, uint64_t number )
+{ return sendall(fd, (const char *) &number, sizeof(number)); }
+
+bool receivenumber( int fd, uint64_t & number )
+{ return receiveall(fd, (char *) &number, sizeof(number)); }
+
+bool sendstring( int fd, const string & text )
+{ return sendnumber(fd, text.size()) && sendall(fd, text.data(), text.size()); }
+
+bool receivestring( int fd, string & text )
+{
+  uint64_t size;
+  if( !receivenumber(fd, size) )
+  { return false; }
+  text.resize(size);
+  return receiveall(fd, &text[0], size);
+}
+
+string defaultsocket()
+{
+  const char * env = getenv("MILA_SERVER");
+  if( env && *env )
+  { return env; }
+  // a directory only the user can get into, nobody else can bind the socket before the server does
+  const char * runtimeDir = getenv("XDG_RUNTIME_DIR");
+  if( runtimeDir && *runtimeDir )
+  { return string(runtimeDir) + "/mila.sock"; }
+  return "/tmp/mila-" + to_string(getuid()) + "/mila.sock";
+}
+
+bool sameuser( int fd )
+{
+#ifdef SO_PEERCRED
+  ucred peer;
+  socklen_t size = sizeof(peer);
+  return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) == 0 && peer.uid == getuid();
+#else
+  uid_t uid;
+  gid_t gid;
+  return getpeereid(fd, &uid, &gid) == 0 && uid == getuid();
+#endif
+}
+
+int connectto( const string & path )
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if( path.size() >= sizeof(address.sun_path) )
+  { return -1; }
+  memcpy(address.sun_path, path.c_str(), path.size());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if( fd < 0 )
+  { return -1; }
+  if( connect(fd, (const sockaddr *) &address, sizeof(address)) != 0 )
+  {
+    close(fd);
+    return -1;
+  }
+  // the sources go only to a server of the same user
+  if( !sameuser(fd) )
+  {
+    close(fd);
+    fprintf(stderr, "The server at %s runs as another user, it isn't used\n", path.c_str());
+    return -1;
+  }
+  return fd;
+}
+
+// ( path ) from the working directory, the server's one isn't ours
+static string absolute( const string & path )
+{
+  char directory[4096];
+  if( path.empty() || path[0] == '/' || !getcwd(directory, sizeof(directory)) )
+  { return path; }
+  return string(directory) + "/" + path;
+}
+
+static string filename( const string & path )
+{
+  size_t slash = path.rfind('/');
+  return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+bool runclient( const string & path, int argc, char * argv[], int & exitcode )
+{
+  vector< string > arguments;
+  const char * cacheEnv = getenv("MILA_CACHE_DIR");
+  if( cacheEnv && *cacheEnv )
+  { arguments.push_back("--cache-dir=" + absolute(cacheEnv)); }
+  const char * inputFile = nullptr;
+  string outputFile;
+  // the answer carries the bytes of an executable, not its permissions
+  bool executable = false;
+  for( int i = 1; i < argc; i++ )
+  {
+    string arg = argv[i];
+    if( arg == "--run" || arg == "--tiered" || arg == "--lex-check" || arg == "--help" )
+    { return false; }
+    else if( arg.rfind("--connect", 0) == 0 )
+    { continue; }
+    else if( arg.rfind("--cache-dir=", 0) == 0 )
+    { arguments.push_back("--cache-dir=" + absolute(arg.substr(12))); }
+    else if( arg.rfind("--incremental=", 0) == 0 )
+    { arguments.push_back("--incremental=" + absolute(arg.substr(14))); }
+    else if( arg.rfind("--runtime=", 0) == 0 )
+    { arguments.push_back("--runtime=" + absolute(arg.substr(10))); }
+    else if( arg.rfind("--emit=", 0) == 0 )
+    {
+      executable = arg == "--emit=exe";
+      arguments.push_back(arg);
+    }
+    else if( arg == "-o" && i + 1 < argc )
+    { outputFile = argv[++i]; }
+    else if( arg.rfind("-o", 0) == 0 && arg.size() > 2 )
+    { outputFile = arg.substr(2); }
+    // a missing output name and a second program are reported by the compiler, the server rejects unknown options
+    else if( arg == "-o" || ( inputFile && ( arg.size() < 2 || arg[0] != '-' ) ) )
+    { return false; }
+    else if( arg.size() > 1 && arg[0] == '-' )
+    { arguments.push_back(arg); }
+    else
+    { inputFile = argv[i]; }
+  }
+  // the server writes the output in a directory of its own under the same name, it comes back in the answer
+  if( !outputFile.empty() )
+  {
+    arguments.push_back("-o");
+    arguments.push_back(outputFile == "-" ? outputFile : filename(outputFile));
+  }
+
+  int connection = connectto(path);
+  if( connection < 0 )
+  { return false; }
+  exitcode = 1;
+  sourcebuffer input;
+  if( !( inputFile ? input.openfile(inputFile) : input.openstdin() ) )
+  {
+    close(connection);
+    fprintf(stderr, "Could not read the program: %s\n", inputFile ? inputFile : "stdin");
+    return true;
+  }
+
+  bool sent = sendnumber(connection, arguments.size());
+  for( const string & argument : arguments )
+  { sent = sent && sendstring(connection, argument); }
+  sent = sent && sendstring(connection, inputFile ? filename(inputFile) : "") &&
+         sendnumber(connection, input.size()) && sendall(connection, input.begin(), input.size());
+  uint64_t code;
+  string name, output, out, err;
+  bool answered = sent && receivenumber(connection, code) && receivestring(connection, name) &&
+                  receivestring(connection, output) && receivestring(connection, out) && receivestring(connection, err);
+  close(connection);
+  if( !answered )
+  {
+    fprintf(stderr, "The server at %s didn't answer\n", path.c_str());
+    return true;
+  }
+
+  fwrite(out.data(), 1, out.size(), stdout);
+  fflush(stdout);
+  fwrite(err.data(), 1, err.size(), stderr);
+  exitcode = (int) (int64_t) code;
+  // without -o the server names the output, only a plain name in the working directory is taken from it
+  if( outputFile.empty() && ( name.find('/') != string::npos || name == "." || name == ".." ) )
+  {
+    fprintf(stderr, "The server at %s answered with an output outside the working directory: %s\n", path.c_str(), name.c_str());
+    exitcode = 1;
+    return true;
+  }
+  if( !name.empty() && outputFile != "-" )
+  {
+    string destination = outputFile.empty() ? name : outputFile;
+    FILE * dest = fopen(destination.c_str(), "wb");
+    if( !dest )
+    {
+      fprintf(stderr, "Could not open file: %s: %s\n", destination.c_str(), strerror(errno));
+      exitcode = 1;
+      return true;
+    }
+    bool written = fwrite(output.data(), 1, output.size(), dest) == output.size();
+    if( fclose(dest) != 0 || !written )
+    {
+      fprintf(stderr, "Could not write file: %s\n", destination.c_str());
+      exitcode = 1;
+    }
+    else if( executable )
+    {
+      mode_t mask = umask(0);
+      umask(mask);
+      chmod(destination.c_str(), 0777 & ~mask);
+    }
+  }
+  return true;
+}
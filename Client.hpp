@@ -0,0 +1,36 @@
+#ifndef PJPPROJECT_CLIENT_HPP
+#define PJPPROJECT_CLIENT_HPP
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// " CLIENT " of the compile server ( Server.hpp ). It doesn't use LLVM so mila-client starts without loading it, which
+// is most of what a compilation of a small program costs
+
+// " PROTOCOL " every message is a sequence of strings, each one its length as 8 bytes and then its bytes. Both ends
+// are on the same machine, the lengths are in its byte order
+//   request:  number of arguments, the arguments, the name of the input ( empty for the stdin ), the source
+//   answer:   exit code, name of the output ( empty if none was written ), the output, the stdout, the stderr
+bool sendall( int fd, const char * data, size_t size );
+bool receiveall( int fd, char * data, size_t size );
+bool sendnumber( int fd, uint64_t number );
+bool receivenumber( int fd, uint64_t & number );
+bool sendstring( int fd, const string & text );
+bool receivestring( int fd, string & text );
+
+// The socket of MILA_SERVER in the environment, $XDG_RUNTIME_DIR/mila.sock or /tmp/mila-<uid>/mila.sock without it
+string defaultsocket();
+// Whether the process at the other end of the socket ( fd ) runs as the same user
+bool sameuser( int fd );
+// Socket connected to the server at ( path ), -1 if none is listening there or it runs as another user
+int connectto( const string & path );
+
+// Sends the compilation the arguments ( argc, argv ) ask for to the server at ( path ) and writes its output where the
+// compiler would have. Returns false without sending anything if the arguments run the program ( --run, --tiered,
+// --lex-check ), are wrong in a way the compiler reports ( --help, -o without a name, two programs ) or no server
+// is listening, the compiler has to do it then. Otherwise ( exitcode ) is the one of the compilation
+bool runclient( const string & path, int argc, char * argv[], int & exitcode );
+
+#endif //PJPPROJECT_CLIENT_HPP
@@ -0,0 +1,5 @@
+# Writes the bytes of the file INPUT to OUTPUT as a list of numbers separated by commas, the initializer of an array
+#   cmake -DINPUT=fce.bc -DOUTPUT=fcebitcode.inc -P Embed.cmake
+file(READ ${INPUT} BYTES HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," BYTES ${BYTES})
+file(WRITE ${OUTPUT} "${BYTES}\n")
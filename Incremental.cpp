@@ -0,0 +1,79 @@
+#include "Incremental.hpp"
+#include "Cache.hpp"
+#include "Split.hpp"
+#include "ast.hpp"
+
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <vector>
+
+// Names and initial values of the global variables, they are defined by the object of main
+static string globalsignature( const Module & module )
+{
+  string signature;
+  raw_string_ostream out(signature);
+  for( const GlobalVariable & g : module.globals() )
+  {
+    out << g.getName() << '=';
+    if( auto * init = dyn_cast_or_null<ConstantInt>(g.hasInitializer() ? g.getInitializer() : nullptr) )
+    { out << init->getSExtValue(); }
+    out << ';';
+  }
+  return out.str();
+}
+
+bool emitincremental( const Module & module, const targetspec & target, unsigned jobs, const string & options,
+                      const string & directory, const string & path, bool stats )
+{
+  compilecache store(directory);
+  string globals = globalsignature(module);
+
+  // module order keeps the archive the same for the same program
+  vector< unique_ptr< MemoryBuffer > > objects;
+  vector< string > keys;
+  // the functions missing from the store, each one alone in a bitcode module
+  vector< size_t > missing;
+  vector< string > parts;
+  for( const Function & f : module )
+  {
+    if( f.isDeclaration() )
+    { continue; }
+    auto found = functionhashes.find(&f);
+    if( found == functionhashes.end() )
+    {
+      errs() << "incremental: " << f.getName() << " has no hash\n";
+      return false;
+    }
+    bool withglobals = f.getName() == "main";
+    keys.push_back(compilecache::key(withglobals ? found->second + globals : found->second, options));
+    objects.push_back(store.lookup(keys.back()));
+    if( !objects.back() )
+    {
+      missing.push_back(objects.size() - 1);
+      parts.push_back(writebitcode(*extract(module, { &f }, withglobals)));
+    }
+  }
+
+  vector< unique_ptr< MemoryBuffer > > compiled;
+  if( !compileparallel(parts, target, jobs, compiled) )
+  { return false; }
+  for( size_t i = 0; i < missing.size(); i++ )
+  {
+    if( !store.store(keys[missing[i]], compiled[i]->getBuffer()) )
+    { errs() << "Could not write to the incremental store: " << directory << "\n"; }
+    objects[missing[i]] = move(compiled[i]);
+  }
+
+  // the members are named by their keys, function names may contain characters archives don't like
+  for( string & key : keys )
+  { key += ".o"; }
+  if( !writearchive(path, objects, keys, Triple(target.triple)) )
+  { return false; }
+
+  if( stats )
+  {
+    fprintf(stderr, "incremental: %zu of %zu functions compiled, %zu reused from %s\n",
+            missing.size(), objects.size(), objects.size() - missing.size(), directory.c_str());
+  }
+  return true;
+}
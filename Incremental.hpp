@@ -0,0 +1,20 @@
+#ifndef PJPPROJECT_INCREMENTAL_HPP
+#define PJPPROJECT_INCREMENTAL_HPP
+
+#include "llvm/IR/Module.h"
+#include <string>
+
+#include "Split.hpp"
+
+using namespace llvm;
+using namespace std;
+
+// " INCREMENTAL OBJECTS " ( --incremental ) writes ( module ) to ( path ) as an archive of one object per function.
+// The objects are kept in the store ( directory ) under the key of the function's hash ( functionhashes ) and the
+// ( options ), only the functions missing from it are optimized and compiled for ( target ), on ( jobs ) threads.
+// Every function is optimized on its own so a change never needs its callers compiled again, main carries
+// the global variables. Returns false if an object couldn't be made or the archive written
+bool emitincremental( const Module & module, const targetspec & target, unsigned jobs, const string & options,
+                      const string & directory, const string & path, bool stats );
+
+#endif //PJPPROJECT_INCREMENTAL_HPP
@@ -0,0 +1,71 @@
+#include "Jit.hpp"
+#include "ast.hpp"
+
+#include "llvm/MC/SubtargetFeature.h"
+#include <cstdio>
+
+using namespace llvm::orc;
+
+// " RUNTIME " the functions of fce.c for programs run inside the compiler's process
+static int jitwriteln( int x )
+{
+  printf("%d\n", x);
+  return 0;
+}
+
+static int jitwrite( int x )
+{
+  printf("%d", x);
+  return 0;
+}
+
+static int jitreadln( int * x )
+{
+  scanf("%d", x);
+  return 0;
+}
+
+Error defineruntime( LLJIT & jit )
+{
+  SymbolMap runtime;
+  runtime[jit.mangleAndIntern("writeln")] = JITEvaluatedSymbol(pointerToJITTargetAddress(&jitwriteln), JITSymbolFlags::Exported);
+  runtime[jit.mangleAndIntern("write")] = JITEvaluatedSymbol(pointerToJITTargetAddress(&jitwrite), JITSymbolFlags::Exported);
+  runtime[jit.mangleAndIntern("readln")] = JITEvaluatedSymbol(pointerToJITTargetAddress(&jitreadln), JITSymbolFlags::Exported);
+  return jit.getMainJITDylib().define(absoluteSymbols(move(runtime)));
+}
+
+static bool LogErrorJ( const char * message, Error error )
+{
+  errs() << message << ": " << toString(move(error)) << "\n";
+  return false;
+}
+
+bool runjit( const string & triple, const string & cpu, const string & features, optlevel level, int & exitcode )
+{
+  JITTargetMachineBuilder machine((Triple(triple)));
+  machine.setCPU(cpu);
+  machine.addFeatures(SubtargetFeatures(features).getFeatures());
+  machine.setCodeGenOptLevel(codegenlevel(level));
+
+  auto jit = LLJITBuilder().setJITTargetMachineBuilder(move(machine)).create();
+  if( !jit )
+  { return LogErrorJ("Could not create the JIT", jit.takeError()); }
+
+  if( Error error = defineruntime(**jit) )
+  { return LogErrorJ("Could not bind the runtime", move(error)); }
+
+  // the per function passes point into the module that's handed over
+  fpm.reset();
+  if( Error error = (*jit)->addIRModule(ThreadSafeModule(move(module), move(context))) )
+  { return LogErrorJ("Could not add the module", move(error)); }
+
+  // looking main up compiles the module
+  auto entry = (*jit)->lookup("main");
+  if( !entry )
+  { return LogErrorJ("Could not compile main", entry.takeError()); }
+
+  auto mainfunc = (int (*)()) entry->getAddress();
+  exitcode = mainfunc();
+  fflush(stdout);
+  return true;
+}
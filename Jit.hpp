@@ -0,0 +1,19 @@
+#ifndef PJPPROJECT_JIT_HPP
+#define PJPPROJECT_JIT_HPP
+
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include <string>
+
+#include "Optimizer.hpp"
+
+using namespace std;
+
+// " JIT " compiles the finished ( module ) in memory with ORC's LLJIT for the given target and calls its main,
+// writeln, write and readln are bound to functions of the compiler itself so nothing is linked on disk.
+// Takes over ( module ) and ( context ), returns false if the program couldn't be compiled
+bool runjit( const string & triple, const string & cpu, const string & features, optlevel level, int & exitcode );
+
+// Binds writeln, write and readln of the code compiled by ( jit ) to the compiler's own functions
+Error defineruntime( orc::LLJIT & jit );
+
+#endif //PJPPROJECT_JIT_HPP
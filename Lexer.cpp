@@ -1,179 +1,426 @@
 #include "Lexer.hpp"
 
- string idname;
+#include <cstring>
+#include <thread>
+
+ string_view idname;
+ int idnum;
  int value;
+ interner identifiers;
+
+ // the lexer behind ( setlexerinput ) and ( gettok )
+ static lexer mainlexer(identifiers);
+
+ void setlexerinput( const sourcebuffer & src )
+ { setlexerinput(src.begin(), src.end()); }
 
- // boolean helper function checks whether the charecter could be a two charecter operation ( := / <= / != )
- bool twocharop( char c )
+ void setlexerinput( const char * begin, const char * end )
+ { mainlexer.reset(begin, end); }
+
+ int gettok()
  {
-   // : < = > ! |
-   if( c != 59 && ( ( c > 57 && c < 67 ) || c == 33 || c == 124 ) )
-   {  return true; }
-   else
-   {  return false; }
+   int tok = mainlexer.gettok();
+   idname = mainlexer.idname;
+   idnum = mainlexer.idnum;
+   value = mainlexer.value;
+   return tok;
  }
 
-int gettok() {
-    static int input = ' ';
+ // returns the token of a two charecter operation ( := / <= / != ... ) or 0 if ( first, second ) isn't one
+ static int twocharop( char first, char second )
+ {
+   switch( first )
+   {
+     case '!':
+       return second == '=' ? tok_notequal : 0;
+     case '<':
+       return second == '=' ? tok_lessequal : 0;
+     case '>':
+       return second == '=' ? tok_greaterequal : 0;
+     case ':':
+       return second == '=' ? tok_assign : 0;
+     case '|':
+       return second == '|' ? tok_or : 0;
+     case '=':
+       return second == '=' ? tok_eq : 0;
+     default:
+       return 0;
+   }
+ }
+
+ // returns the keyword token of ( name ) or tok_identifier, keywords are told apart
+ // by their length and first charecter so at most one comparison is made
+ static int keyword( string_view name )
+ {
+   switch( name.size() )
+   {
+     case 2:
+       switch( name[0] )
+       {
+         case 'd': return name == "do" ? tok_do : tok_identifier;
+         case 'i': return name == "if" ? tok_if : tok_identifier;
+         case 'o': return name == "or" ? tok_or : tok_identifier;
+         case 't': return name == "to" ? tok_to : tok_identifier;
+       }
+       break;
+     case 3:
+       switch( name[0] )
+       {
+         case 'a': return name == "and" ? tok_and : tok_identifier;
+         case 'd': return name == "div" ? tok_div : tok_identifier;
+         case 'e': return name == "end" ? tok_end : tok_identifier;
+         case 'f': return name == "for" ? tok_for : tok_identifier;
+         case 'm': return name == "mod" ? tok_mod : tok_identifier;
+         case 'n': return name == "not" ? tok_not : tok_identifier;
+         case 'v': return name == "var" ? tok_var : tok_identifier;
+         case 'x': return name == "xor" ? tok_xor : tok_identifier;
+       }
+       break;
+     case 4:
+       switch( name[0] )
+       {
+         case 'e':
+           if( name == "else" )
+           { return tok_else; }
+           return name == "exit" ? tok_exit : tok_identifier;
+         case 't': return name == "then" ? tok_then : tok_identifier;
+       }
+       break;
+     case 5:
+       switch( name[0] )
+       {
+         case 'b': return name == "begin" ? tok_begin : tok_identifier;
+         case 'c': return name == "const" ? tok_const : tok_identifier;
+         case 'w': return name == "while" ? tok_while : tok_identifier;
+       }
+       break;
+     case 6:
+       return name == "downto" ? tok_downto : tok_identifier;
+     case 7:
+       switch( name[0] )
+       {
+         case 'f': return name == "forward" ? tok_forward : tok_identifier;
+         case 'i': return name == "integer" ? tok_integer : tok_identifier;
+         case 'p': return name == "program" ? tok_program : tok_identifier;
+       }
+       break;
+     case 8:
+       return name == "function" ? tok_function : tok_identifier;
+     case 9:
+       return name == "procedure" ? tok_procedure : tok_identifier;
+   }
+   return tok_identifier;
+ }
 
-    // skip whitespaces
-    while( isspace(input) )
-    { input = getchar(); }
+void lexer::reset( const char * begin, const char * end )
+{
+  cursor = begin;
+  last = end;
+  line = 1;
+  linestart = begin;
+}
+
+uint32_t lexer::currentline() const
+{ return line; }
+
+int lexer::gettok() {
+    while( true )
+    {
+      // skip whitespaces
+      cursor = scan.skipspace(cursor, last, line, linestart);
+
+      // " COMMENTS " (#) loop until the end of the line / file is reached
+      if( cursor < last && *cursor == '#' )
+      {
+        cursor = scan.skipcomment(cursor + 1, last);
+        continue;
+      }
+      break;
+    }
+
+    tokline = line;
+    tokcolumn = cursor - linestart + 1;
+
+    // " EOF "
+    if( cursor >= last )
+    { return tok_eof; }
 
     // " IDENTIFIERS "
-    if( isalpha(input) )
+    if( isalpha((unsigned char) *cursor) )
     {
-      idname = input;
-      // keep reading and appending identifier name [A-Z][a-z][0-9]
-      while( isalnum(input = getchar()) )
-      { idname += input; }
+      const char * start = cursor;
+      // keep reading identifier name [A-Z][a-z][0-9]
+      cursor = scan.skipalnum(cursor + 1, last);
+      idname = string_view(start, cursor - start);
       // check if the name matches a keyword identifier
-      if( idname == "begin" )
-      { return tok_begin; }
-      if( idname == "end" )
-      { return tok_end; }
-      if( idname == "const" )
-      { return tok_const; }
-      if( idname == "procedure")
-      { return tok_procedure; }
-      if( idname == "forward" )
-      { return tok_forward; }
-      if( idname == "function" )
-      { return tok_function; }
-      if( idname == "if" )
-      { return tok_if; }
-      if( idname == "then" )
-      { return tok_then; }
-      if( idname == "else" )
-      { return tok_else; }
-      if( idname == "program" )
-      { return tok_program; }
-      if( idname == "while" )
-      { return tok_while; }
-      if( idname == "exit" )
-      { return tok_exit; }
-      if( idname == "var" )
-      { return tok_var; }
-      if( idname == "integer" )
-      { return tok_integer; }
-      if( idname == "for" )
-      { return tok_for; }
-      if( idname == "do" )
-      { return tok_do; }
-      if( idname == "to" )
-      { return tok_to; }
-      if( idname == "downto" )
-      { return tok_downto; }
+      int keywordtok = keyword(idname);
+      if( keywordtok != tok_identifier )
+      { return keywordtok; }
       // else its an identifier and its name is stored in ( idname )
+      idnum = ids.intern(idname);
       return tok_identifier;
     }
 
     // " DECIMAL " NOs [0 - 9]
-    if( isdigit(input) )
+    if( isdigit((unsigned char) *cursor) )
     {
-      // read the whole number into the string ( number )
-      string number;
-      do
-      {
-        number += input;
-        input = getchar();
-      } while( isdigit(input) );
-      // convert the string into an integer of base 10
-      value = (int) strtod(number.c_str(), nullptr);
+      unsigned number;
+      cursor = scan.parsedecimal(cursor, last, number);
+      value = (int) number;
       return tok_number;
     }
 
     // " OCTAL " NOs [0 - 7] (&)
-    if( input == '&' )
+    if( *cursor == '&' )
     {
-      input = getchar();
-      string number;
-      do
-      {
-        number += input;
-        input = getchar();
-      } while( isdigit(input) );
-      // convert the string into an integer of base 8
-      char * tmp;
-      value = (int) strtol(number.c_str(), &tmp, 8);
+      unsigned number;
+      cursor = scan.parseoctal(cursor + 1, last, number);
+      value = (int) number;
       return tok_number;
     }
 
     // " HEXIDECIMAL " NOs [A-F][a-f][0-9] ($)
-    if( input == '$' )
+    if( *cursor == '$' )
     {
-      input = getchar();
-      string number;
-      do
-      {
-        number += input;
-        input = getchar();
-      } while( isdigit(input) || isalnum(input) );
-      // convert the string into an integer of base 8
-      char * tmp;
-      value = (int) strtol(number.c_str(), &tmp, 16);
+      unsigned number;
+      cursor = scan.parsehex(cursor + 1, last, number);
+      value = (int) number;
       return tok_number;
     }
 
-    // " COMMENTS " (#)
-    if( input == '#')
-    {
-      // loop until the end of the line / file is reached
-      do
-      { input = getchar(); }
-      while( input != EOF && input != '\n' && input != '\r' );
-      if( input != EOF )
-      { return gettok(); }
-    }
-
     // " OPERATORS "
-    if( twocharop(input) )
+    if( cursor + 1 < last )
     {
-      string operation;
-      operation = input;
-      while( twocharop(cin.peek()) )
+      if( int operation = twocharop(cursor[0], cursor[1]) )
       {
-        input = getchar();
-        operation += input;
-        if( operation == "!=" )
-        {
-          input = getchar();
-          return tok_notequal;
-        }
-        if( operation == "<=" )
-        {
-          input = getchar();
-          return tok_lessequal;
-        }
-        if( operation == ">=" )
-        {
-          input = getchar();
-          return tok_greaterequal;
-        }
-        if( operation == ":=" )
-        {
-          input = getchar();
-          return tok_assign;
-        }
-        if( operation == "||" )
-        {
-          input = getchar();
-          return tok_or;
-        }
-        if( operation == "==" )
-        {
-          input = getchar();
-          return tok_eq;
-        }
+        cursor += 2;
+        return operation;
       }
     }
 
-    // " EOF "
-    if( input == EOF )
-    { return tok_eof; }
-
     // RETURN ASCII value
-    int ascii = input;
-    input = getchar();
-    return ascii;
+    return (unsigned char) *cursor++;
+}
+
+// " IDENTIFIER TABLE "
+interner::interner() : slots(64, -1) {}
+
+// FNV-1a
+uint32_t interner::hash( string_view name )
+{
+  uint32_t h = 2166136261u;
+  for( char c : name )
+  { h = (h ^ (unsigned char) c) * 16777619u; }
+  return h;
+}
+
+// Doubles the table and reinserts all ids, keeps the load factor under 1/2
+void interner::grow()
+{
+  vector<int> bigger(slots.size() * 2, -1);
+  size_t mask = bigger.size() - 1;
+  for( int id = 0; id < (int) names.size(); id++ )
+  {
+    size_t i = hashes[id] & mask;
+    while( bigger[i] >= 0 )
+    { i = (i + 1) & mask; }
+    bigger[i] = id;
+  }
+  slots.swap(bigger);
+}
+
+int interner::intern( string_view name )
+{
+  uint32_t h = hash(name);
+  size_t mask = slots.size() - 1;
+  size_t i = h & mask;
+  while( slots[i] >= 0 )
+  {
+    int id = slots[i];
+    if( hashes[id] == h && names[id] == name )
+    { return id; }
+    i = (i + 1) & mask;
+  }
+
+  int id = names.size();
+  names.push_back(name);
+  hashes.push_back(h);
+  slots[i] = id;
+  if( names.size() * 2 > slots.size() )
+  { grow(); }
+  return id;
+}
+
+int interner::find( string_view name ) const
+{
+  uint32_t h = hash(name);
+  size_t mask = slots.size() - 1;
+  for( size_t i = h & mask; slots[i] >= 0; i = (i + 1) & mask )
+  {
+    int id = slots[i];
+    if( hashes[id] == h && names[id] == name )
+    { return id; }
+  }
+  return -1;
+}
+
+string_view interner::name( int id ) const
+{ return names[id]; }
+size_t interner::size() const
+{ return names.size(); }
+
+// " TOKEN STREAM "
+void tokenstream::push( int kind, int payload, uint32_t line, uint32_t column )
+{
+  kinds.push_back(kind);
+  payloads.push_back(payload);
+  lines.push_back(line);
+  columns.push_back(column);
+}
+void tokenstream::clear()
+{
+  kinds.clear();
+  payloads.clear();
+  lines.clear();
+  columns.clear();
+}
+void tokenstream::reserve( size_t count )
+{
+  kinds.reserve(count);
+  payloads.reserve(count);
+  lines.reserve(count);
+  columns.reserve(count);
+}
+size_t tokenstream::size() const
+{ return kinds.size(); }
+bool tokenstream::operator==( const tokenstream & other ) const
+{
+  return kinds == other.kinds && payloads == other.payloads &&
+         lines == other.lines && columns == other.columns;
+}
+
+void tokenstream::resize( size_t count )
+{
+  kinds.resize(count);
+  payloads.resize(count);
+  lines.resize(count);
+  columns.resize(count);
+}
+
+// Lexes the whole range of ( lex ) into ( tokens ), ending with tok_eof
+static void lexall( lexer & lex, const char * begin, const char * end, tokenstream & tokens )
+{
+  lex.reset(begin, end);
+  tokens.clear();
+  // programs average well over 4 charecters per token
+  tokens.reserve((end - begin) / 4 + 1);
+
+  int tok;
+  do
+  {
+    tok = lex.gettok();
+    int payload = 0;
+    if( tok == tok_identifier )
+    { payload = lex.idnum; }
+    else if( tok == tok_number )
+    { payload = lex.value; }
+    tokens.push(tok, payload, lex.tokline, lex.tokcolumn);
+  } while( tok != tok_eof );
+}
+
+// inputs smaller than this are lexed sequentially, starting threads would cost more than it saves
+static const size_t parallelthreshold = 1 << 20;
+
+// " CHUNK " of the input lexed on its own thread with its own identifier table
+struct lexchunk
+{
+  const char * begin;
+  const char * end;
+  interner ids;
+  tokenstream tokens;
+  // newlines inside the chunk
+  uint32_t lines;
+};
+
+void tokenize( const char * begin, const char * end, tokenstream & tokens, unsigned threads, const scankernels & scan )
+{
+  size_t size = end - begin;
+  if( threads == 0 )
+  { threads = max(1u, thread::hardware_concurrency()); }
+  if( threads == 1 || size < parallelthreshold )
+  {
+    lexer lex(identifiers, scan);
+    lexall(lex, begin, end, tokens);
+    return;
+  }
+
+  // Split right after a newline, no token spans a line and a '#' comment always ends at one
+  vector<lexchunk> chunks(threads);
+  const char * start = begin;
+  for( unsigned i = 0; i < threads; i++ )
+  {
+    const char * stop = end;
+    if( i + 1 < threads )
+    {
+      stop = max(start, begin + size / threads * (i + 1));
+      const char * newline = (const char *) memchr(stop, '\n', end - stop);
+      stop = newline ? newline + 1 : end;
+    }
+    chunks[i].begin = start;
+    chunks[i].end = stop;
+    start = stop;
+  }
+
+  vector<thread> workers;
+  for( auto & c : chunks )
+  {
+    workers.emplace_back([&c, &scan]()
+    {
+      lexer lex(c.ids, scan);
+      lexall(lex, c.begin, c.end, c.tokens);
+      c.lines = lex.currentline() - 1;
+    });
+  }
+  for( auto & w : workers )
+  { w.join(); }
+
+  // Intern the names chunk by chunk in their order of first appearance, which assigns
+  // exactly the ids a sequential lex would, and place every chunk in the final stream
+  vector< vector<int> > remap(chunks.size());
+  vector<size_t> offsets(chunks.size());
+  vector<uint32_t> lineoffsets(chunks.size());
+  size_t count = 0;
+  uint32_t lines = 0;
+  for( size_t i = 0; i < chunks.size(); i++ )
+  {
+    for( size_t id = 0; id < chunks[i].ids.size(); id++ )
+    { remap[i].push_back(identifiers.intern(chunks[i].ids.name(id))); }
+    offsets[i] = count;
+    lineoffsets[i] = lines;
+    // only the last chunk keeps its closing tok_eof
+    count += chunks[i].tokens.size() - ( i + 1 < chunks.size() ? 1 : 0 );
+    lines += chunks[i].lines;
+  }
+
+  tokens.clear();
+  tokens.resize(count);
+  workers.clear();
+  for( size_t i = 0; i < chunks.size(); i++ )
+  {
+    workers.emplace_back([&, i]()
+    {
+      const tokenstream & from = chunks[i].tokens;
+      size_t n = from.size() - ( i + 1 < chunks.size() ? 1 : 0 );
+      size_t at = offsets[i];
+      for( size_t t = 0; t < n; t++ )
+      {
+        tokens.kinds[at + t] = from.kinds[t];
+        tokens.payloads[at + t] = from.kinds[t] == tok_identifier ? remap[i][from.payloads[t]] : from.payloads[t];
+        tokens.lines[at + t] = from.lines[t] + lineoffsets[i];
+        tokens.columns[at + t] = from.columns[t];
+      }
+    });
+  }
+  for( auto & w : workers )
+  { w.join(); }
 }
@@ -1,15 +1,119 @@
 #ifndef PJPPROJECT_LEXER_HPP
 #define PJPPROJECT_LEXER_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <string_view>
+#include <vector>
 using namespace std;
 
-// set if ( tok_identifier )
-extern string idname;
+#include "Scan.hpp"
+#include "Source.hpp"
+
+// set if ( tok_identifier ), a view into the source buffer
+extern string_view idname;
+// set if ( tok_identifier ), the interned id of ( idname )
+extern int idnum;
 // set if ( tok_number )
 extern int value;
 
-// returns the next token value from the stdin
+// " IDENTIFIER TABLE " gives every distinct identifier name a dense integer id ( 0, 1, 2 ... )
+// in the order of their first appearance, names are views that have to outlive the table
+class interner
+{
+private:
+  // id -> name
+  vector< string_view > names;
+  vector< uint32_t > hashes;
+  // open addressing hash table of ids, -1 marks an empty slot
+  vector< int > slots;
+
+  static uint32_t hash( string_view name );
+  void grow();
+
+public:
+  // " CONSTRUCTOR "
+  interner();
+
+  // Returns the id of ( name ), assigning the next free id to unseen names
+  int intern( string_view name );
+  // Returns the id of ( name ) or -1 if it was never interned
+  int find( string_view name ) const;
+
+  // " GETTERS "
+  string_view name( int id ) const;
+  size_t size() const;
+};
+
+extern interner identifiers;
+
+// " TOKEN STREAM " the whole program lexed up front, one entry per token stored as a structure of arrays
+class tokenstream
+{
+public:
+  // token value ( enum Token or an ASCII charecter )
+  vector< int16_t > kinds;
+  // interned id for tok_identifier, the value for tok_number, 0 otherwise
+  vector< int32_t > payloads;
+  // 1-based source location of the first charecter of the token
+  vector< uint32_t > lines;
+  vector< uint32_t > columns;
+
+  void push( int kind, int payload, uint32_t line, uint32_t column );
+  void clear();
+  void reserve( size_t count );
+  void resize( size_t count );
+  size_t size() const;
+  bool operator==( const tokenstream & other ) const;
+};
+
+// " LEXER " scanning state over a range of charecters, identifiers are interned into ( ids )
+class lexer
+{
+private:
+  const char * cursor;
+  const char * last;
+  // current line number and the position where it starts
+  uint32_t line;
+  const char * linestart;
+  interner & ids;
+  const scankernels & scan;
+
+public:
+  // set if ( tok_identifier ), a view into the scanned charecters
+  string_view idname;
+  // set if ( tok_identifier ), the interned id of ( idname )
+  int idnum;
+  // set if ( tok_number )
+  int value;
+  // 1-based line and column of the last token
+  uint32_t tokline;
+  uint32_t tokcolumn;
+
+  // " CONSTRUCTOR "
+  lexer( interner & i, const scankernels & k = bestkernels() ) :
+  cursor(nullptr), last(nullptr), line(1), linestart(nullptr), ids(i), scan(k),
+  idnum(0), value(0), tokline(1), tokcolumn(1) {}
+
+  // starts scanning the charecters in [ begin, end ) from line 1
+  void reset( const char * begin, const char * end );
+  // returns the next token value
+  int gettok();
+  // number of the line the lexer is currently on
+  uint32_t currentline() const;
+};
+
+// lexes the charecters in [ begin, end ) into ( tokens ), the stream always ends with tok_eof
+// large inputs are split at line boundaries and lexed on up to ( threads ) threads, 0 picks the
+// number of cores, the result is identical to a sequential lex
+void tokenize( const char * begin, const char * end, tokenstream & tokens, unsigned threads = 1,
+               const scankernels & scan = bestkernels() );
+
+// makes ( gettok ) scan the given source buffer from its beginning
+void setlexerinput( const sourcebuffer & src );
+// makes ( gettok ) scan the charecters in [ begin, end )
+void setlexerinput( const char * begin, const char * end );
+// returns the next token value from the source buffer, interning identifiers into ( identifiers )
 int gettok();
 
 // RETURNS ASCII value ( 0 - 255 ) for unknown chars, or ( -32, -1 ) for valid tokens
@@ -0,0 +1,118 @@
+#include "Link.hpp"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+// The file ( name ) in the directory of the compiler ( executable )
+static string besidecompiler( const string & executable, StringRef name )
+{
+  SmallString<128> path(sys::path::parent_path(executable));
+  sys::path::append(path, name);
+  return string(path.str());
+}
+
+string defaultruntime( const string & executable )
+{ return besidecompiler(executable, "fce.o"); }
+
+string defaultstart( const string & executable )
+{ return besidecompiler(executable, "fcestart.o"); }
+
+// A file descriptor the linker inherits holding ( object ), -1 if there are no memory files
+static int memoryfile( StringRef object )
+{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  // without MFD_CLOEXEC, the linker and the processes its driver starts get it too
+  int fd = memfd_create("mila-object", 0);
+  if( fd < 0 )
+  { return -1; }
+  for( size_t written = 0; written < object.size(); )
+  {
+    ssize_t n = write(fd, object.data() + written, object.size() - written);
+    if( n <= 0 )
+    {
+      close(fd);
+      return -1;
+    }
+    written += n;
+  }
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+bool linkexecutable( StringRef object, const vector< string > & runtime, const string & linker, bool freestanding,
+                     const string & path )
+{
+  auto program = sys::findProgramByName(linker);
+  if( !program )
+  {
+    errs() << "Could not find the linker: " << linker << "\n";
+    return false;
+  }
+
+  // a temporary file only where there are no memory files
+  string objectpath;
+  int fd = memoryfile(object);
+  SmallString<128> temporary;
+  if( fd >= 0 )
+  { objectpath = "/dev/fd/" + to_string(fd); }
+  else
+  {
+    int tmp;
+    if( sys::fs::createTemporaryFile("mila", "o", tmp, temporary) )
+    {
+      errs() << "Could not write the object for the linker\n";
+      return false;
+    }
+    raw_fd_ostream out(tmp, true);
+    out << object;
+    objectpath = string(temporary.str());
+  }
+  FileRemover remover(temporary, !temporary.empty());
+
+  vector< StringRef > arguments{ linker, "-o", path, objectpath };
+  arguments.insert(arguments.end(), runtime.begin(), runtime.end());
+  // no dynamic loader, C library or its startup files
+  if( freestanding )
+  { arguments.insert(arguments.end(), { "-static", "-nostdlib" }); }
+  string error;
+  int result = sys::ExecuteAndWait(*program, arguments, None, {}, 0, 0, &error);
+#ifdef __linux__
+  if( fd >= 0 )
+  { close(fd); }
+#endif
+  if( result != 0 )
+  {
+    errs() << "Could not link " << path;
+    if( !error.empty() )
+    { errs() << ": " << error; }
+    errs() << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool markexecutable( const string & path )
+{
+  using namespace sys::fs;
+  // the mode the linker gives its outputs, 0755 without what the umask takes away
+  unsigned mask = 0;
+#ifndef _WIN32
+  mask = umask(0);
+  umask(mask);
+#endif
+  return !setPermissions(path, (perms) ( ( all_read | owner_write | all_exe ) & ~mask ));
+}
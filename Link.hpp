@@ -0,0 +1,31 @@
+#ifndef PJPPROJECT_LINK_HPP
+#define PJPPROJECT_LINK_HPP
+
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// " LINKING " ( --emit=exe ) links the object compiled in memory with the prebuilt runtime into an executable by a
+// single call of the linker driver. On Linux the object reaches the linker as a memory file it inherits, nothing
+// is written besides the executable. --freestanding links it statically without the C library, the start object
+// ( fcestart.o ) starts the program and makes the system calls of the runtime
+
+// The runtime object ( fce.o ) the build puts next to the compiler ( executable )
+string defaultruntime( const string & executable );
+// The start object of --freestanding ( fcestart.o ) next to the compiler ( executable )
+string defaultstart( const string & executable );
+
+// Links ( object ) with the ( runtime ) objects into the executable ( path ) by running ( linker ), "cc" or another
+// driver that knows the C library. Without ( runtime ) objects the object is linked alone, it contains the runtime.
+// A ( freestanding ) executable is static and gets neither the C library nor its startup files.
+// Returns false if the linker couldn't be run or failed, its messages go to the stderr
+bool linkexecutable( StringRef object, const vector< string > & runtime, const string & linker, bool freestanding,
+                     const string & path );
+
+// Makes the file ( path ) written by the compiler rather than the linker executable, with the umask applied
+bool markexecutable( const string & path );
+
+#endif //PJPPROJECT_LINK_HPP
@@ -0,0 +1,88 @@
+#include "Optimizer.hpp"
+
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Passes/PassBuilder.h"
+
+// the levels moved out of PassBuilder in LLVM 13
+#if LLVM_VERSION_MAJOR >= 13
+typedef OptimizationLevel passlevel;
+#else
+typedef PassBuilder::OptimizationLevel passlevel;
+#endif
+
+bool parseoptlevel( const string & text, optlevel & level )
+{
+  static const pair< const char *, optlevel > levels[] = {
+    { "0", optlevel::O0 }, { "1", optlevel::O1 }, { "2", optlevel::O2 },
+    { "3", optlevel::O3 }, { "s", optlevel::Os }, { "z", optlevel::Oz }
+  };
+  for( auto & l : levels )
+  {
+    if( text == l.first )
+    {
+      level = l.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+CodeGenOpt::Level codegenlevel( optlevel level )
+{
+  switch( level )
+  {
+    case optlevel::O0:
+      return CodeGenOpt::None;
+    case optlevel::O1:
+      return CodeGenOpt::Less;
+    case optlevel::O3:
+      return CodeGenOpt::Aggressive;
+    default:
+      // -Os and -Oz only shrink the IR, instruction selection stays at the default level like in clang
+      return CodeGenOpt::Default;
+  }
+}
+
+static passlevel passlevelof( optlevel level )
+{
+  switch( level )
+  {
+    case optlevel::O1:
+      return passlevel::O1;
+    case optlevel::O2:
+      return passlevel::O2;
+    case optlevel::O3:
+      return passlevel::O3;
+    case optlevel::Os:
+      return passlevel::Os;
+    case optlevel::Oz:
+      return passlevel::Oz;
+    default:
+      return passlevel::O0;
+  }
+}
+
+void optimizemodule( Module & module, TargetMachine * machine, optlevel level )
+{
+  // LLVM 10 only builds the default pipeline for real levels
+  if( level == optlevel::O0 )
+  { return; }
+
+  // declared from the innermost unit out, the proxies between them are destroyed in the right order
+  LoopAnalysisManager loops;
+  FunctionAnalysisManager functions;
+  CGSCCAnalysisManager callgraph;
+  ModuleAnalysisManager modules;
+
+  PassBuilder passbuilder(machine);
+  functions.registerPass([&] { return passbuilder.buildDefaultAAPipeline(); });
+  passbuilder.registerModuleAnalyses(modules);
+  passbuilder.registerCGSCCAnalyses(callgraph);
+  passbuilder.registerFunctionAnalyses(functions);
+  passbuilder.registerLoopAnalyses(loops);
+  passbuilder.crossRegisterProxies(loops, functions, callgraph, modules);
+
+  ModulePassManager passes = passbuilder.buildPerModuleDefaultPipeline(passlevelof(level));
+  passes.run(module, modules);
+}
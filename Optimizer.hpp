@@ -0,0 +1,25 @@
+#ifndef PJPPROJECT_OPTIMIZER_HPP
+#define PJPPROJECT_OPTIMIZER_HPP
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+#include <cstdint>
+#include <string>
+
+using namespace llvm;
+using namespace std;
+
+// " OPTIMIZATION LEVEL " given by -O0 .. -O3, -Os and -Oz
+enum class optlevel : uint8_t { O0, O1, O2, O3, Os, Oz };
+
+// Parses the text after -O, returns false if it isn't a level
+bool parseoptlevel( const string & text, optlevel & level );
+// Optimization level of the target's code generator matching ( level )
+CodeGenOpt::Level codegenlevel( optlevel level );
+
+// Runs the standard pipeline of the new pass manager for ( level ) over ( module ),
+// ( machine ) lets the passes query the target's costs, -O0 leaves the module as it is
+void optimizemodule( Module & module, TargetMachine * machine, optlevel level );
+
+#endif //PJPPROJECT_OPTIMIZER_HPP
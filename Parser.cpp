@@ -4,31 +4,68 @@
 Parser::Parser() : MilaContext(), MilaBuilder(MilaContext), MilaModule("mila", MilaContext) {}
 
 int currenttok;
-map<char, int> BinopPrecedence;
+array< uint8_t, 256 > userprecedence {};
+tokenstream tokens;
+astbody tree;
+// index of the token ( getNextToken ) returns next
+static size_t nexttok = 0;
 
 int getNextToken()
-{ return currenttok = gettok(); }
+{
+  // keep returning the closing tok_eof once the stream is exhausted
+  size_t index = min(nexttok, tokens.size() - 1);
+  nexttok = index + 1;
+
+  currenttok = tokens.kinds[index];
+  if( currenttok == tok_identifier )
+  {
+    idnum = tokens.payloads[index];
+    idname = identifiers.name(idnum);
+  }
+  else if( currenttok == tok_number )
+  { value = tokens.payloads[index]; }
+  return currenttok;
+}
+
+int peektok( size_t k )
+{ return tokens.kinds[min(tokenindex() + k, tokens.size() - 1)]; }
+
+size_t tokenindex()
+{ return nexttok ? nexttok - 1 : 0; }
+
+void seektok( size_t index )
+{
+  nexttok = index;
+  getNextToken();
+}
 
 // Returns the precedence of the upcoming binary operator token
 int GetTokPrecedence()
 {
-  // not an ASCII or a 2-charecter operator
-  if( !isascii(currenttok) && currenttok != tok_notequal  && currenttok != tok_lessequal
-                           && currenttok != tok_greaterequal  && currenttok != tok_assign
-                           && currenttok != tok_or )
- { return -1; }
- // Ensure that the binary operator was declared and return its precedence
- int precedence = BinopPrecedence[currenttok];
- if( precedence <= 0 )
- {  return -1; }
- return precedence;
+  int precedence = operatorof(currenttok).precedence;
+  // otherwise it has to be an operator the program defined
+  if( precedence == 0 && isascii(currenttok) )
+  { precedence = userprecedence[currenttok]; }
+  return precedence > 0 ? precedence : -1;
+}
+
+// Hands the finished tree of the current top level item over, the next item starts from an empty one
+static astbody taketree()
+{
+  aststats.record(tree);
+  astbody finished = move(tree);
+  tree.clear();
+  return finished;
 }
 
 // Error logging
-unique_ptr<expression> LogError(const char *str)
+size_t errorcount = 0;
+nodeid LogError(const char *str)
 {
-  fprintf(stderr, "ERROR: %s\n", str);
-  return nullptr;
+  errorcount++;
+  size_t index = tokenindex();
+  fprintf(stderr, "ERROR near %u:%u: %s\n", tokens.lines[index], tokens.columns[index], str);
+  return nonode;
 }
 unique_ptr<funcproto> LogErrorP(const char *str)
 {
@@ -69,103 +106,222 @@ const Module & Parser::Generate()
     return this->MilaModule;
 }
 
-// EXPRESSION := UNARY BINOP(RHS)
-unique_ptr<expression> ParseExpression()
+// " EXPRESSION PARSER " state, shared by the nested ParseExpression() calls of if / for bodies,
+// every call works above the sizes the stacks had when it started and shrinks them back
+namespace
 {
-  auto LHS = ParseUnary();
-  if (!LHS)
-  { return nullptr; }
-  return ParseBinOpRHS(0, move(LHS));
+  // a pending operator, prefix ones bind tighter than any binary one
+  struct pendingop
+  {
+    int16_t token;
+    uint8_t precedence;
+    bool rightassoc;
+    bool prefix;
+  };
+
+  // an open '(' or call argument list
+  struct group
+  {
+    // identifier id of the called function, -1 for a bracketed expression
+    int callee;
+    // size of ( operators ) when the group was opened
+    size_t operatorbase;
+    // size of ( arguments ) when the group was opened
+    size_t argumentbase;
+  };
+
+  vector< nodeid > operands;
+  vector< pendingop > operators;
+  vector< group > groups;
+  vector< nodeid > arguments;
 }
 
-// NUMBEREXPR := NUMBER
-unique_ptr<expression> ParseNumberExpr()
+// Replaces the operands of the top pending operator with its node
+static void reduce()
 {
-  auto result = make_unique<numexpr>(value);
-  getNextToken();
-  return move(result);
+  pendingop op = operators.back();
+  operators.pop_back();
+  nodeid rhs = operands.back();
+  operands.pop_back();
+  if( op.prefix )
+  {
+    operands.push_back(tree.add(nodekind::unary, op.token, rhs));
+    return;
+  }
+  nodeid lhs = operands.back();
+  operands.pop_back();
+  // ':=' and '=' are the same assignment
+  int token = op.token == tok_assign ? '=' : op.token;
+  operands.push_back(tree.add(nodekind::binary, token, lhs, rhs));
 }
 
-// PARENTEXPRESSION := ( EXPRESSION )
-unique_ptr<expression> ParseParentExpr()
+// Reduces the pending operators of the innermost group that bind at least as tightly as ( precedence )
+static void reduceabove( size_t base, int precedence, bool rightassoc )
 {
-  // EAT '('
-  getNextToken();
-
-  auto result = ParseExpression();
-  if( !result )
-  { return nullptr; }
+  while( operators.size() > base )
+  {
+    const pendingop & top = operators.back();
+    if( top.precedence < precedence || ( top.precedence == precedence && rightassoc ) )
+    { break; }
+    reduce();
+  }
+}
 
-  if( currenttok != ')' )
-  { return LogError("CLOSING BRACKET ')' MISSING FOR THE EXPRESSION"); }
+// Closes the argument list of ( g ) at the current ')' and pushes the call
+static void finishcall( const group & g )
+{
   // EAT ')'
   getNextToken();
-  return result;
+  // EAT ';'
+  if( currenttok == ';' )
+  { getNextToken(); }
+
+  vector< nodeid > callarguments(arguments.begin() + g.argumentbase, arguments.end());
+  arguments.resize(g.argumentbase);
+  operands.push_back(tree.add(nodekind::call, 0, g.callee, tree.addlist(callarguments)));
 }
 
-// IDENTIFIEREXPR := IDENTIFIER
-// IDENTIFIEREXPR := IDENTIFIER ( EXPRESSION* )
-unique_ptr<expression> ParseIdentifierExpr()
+// EXPRESSION := UNARY ( BINOP UNARY )*
+// UNARY := PREFIXOP* ( PRIMARY / ( EXPRESSION ) / IDENTIFIER ( EXPRESSION, ... ) )
+// An iterative Pratt parser, operators, brackets and call arguments are kept on explicit stacks
+// so the nesting depth is only limited by memory
+nodeid ParseExpression()
 {
-  string identname = idname;
-  getNextToken();
-
-  // If there's no preceding expression then its a variable reference
-  if( currenttok != '(' )
-  { return make_unique<variableexpr>(identname); }
+  size_t operandbase = operands.size();
+  size_t operatorbase = operators.size();
+  size_t groupbase = groups.size();
+  size_t argumentbase = arguments.size();
+  auto fail = [&]()
+  {
+    operands.resize(operandbase);
+    operators.resize(operatorbase);
+    groups.resize(groupbase);
+    arguments.resize(argumentbase);
+    return nonode;
+  };
 
-  // Otherwise its a function call
-  vector<unique_ptr<expression>> arguments;
-  // EAT '('
-  getNextToken();
-  // Accumulate the arguments of the fucntion call
-  if( currenttok != ')' )
+  while( true )
   {
+    // " OPERAND " any ASCII charecter but '(' and ',' starts a prefix operator
+    while( ( isascii(currenttok) && currenttok != '(' && currenttok != ',' ) || operatorof(currenttok).prefix )
+    {
+      operators.push_back({ (int16_t) currenttok, UINT8_MAX, false, true });
+      getNextToken();
+    }
+
+    if( currenttok == '(' )
+    {
+      // EAT '('
+      getNextToken();
+      groups.push_back({ -1, operators.size(), arguments.size() });
+      continue;
+    }
+    if( currenttok == tok_identifier && peektok() == '(' )
+    {
+      group g = { idnum, operators.size(), arguments.size() };
+      // EAT IDENTIFIER '('
+      getNextToken();
+      getNextToken();
+      if( currenttok != ')' )
+      {
+        groups.push_back(g);
+        continue;
+      }
+      finishcall(g);
+    }
+    else
+    {
+      nodeid primary = ParsePrimary();
+      if( primary == nonode )
+      { return fail(); }
+      operands.push_back(primary);
+    }
+
+    // " OPERATORS " after an operand, until one of them needs the next operand
     while( true )
     {
-      if( auto a = ParseExpression() )
-      { arguments.push_back(move(a)); }
-      else
-      { return nullptr; }
+      size_t base = groups.size() > groupbase ? groups.back().operatorbase : operatorbase;
+      int precedence = GetTokPrecedence();
+      if( precedence > 0 )
+      {
+        bool rightassoc = operatorof(currenttok).rightassoc;
+        reduceabove(base, precedence, rightassoc);
+        operators.push_back({ (int16_t) currenttok, (uint8_t) precedence, rightassoc, false });
+        getNextToken();
+        break;
+      }
 
-      if( currenttok == ')' )
-      { break; }
-      if( currenttok != ',' )
-      { return LogError("MISSING SEPERATOR ',' IN LIST OF ARGUMENTS"); }
+      // no operator follows, the operand completes the innermost group
+      reduceabove(base, 0, false);
+      if( groups.size() == groupbase )
+      {
+        nodeid result = operands.back();
+        operands.pop_back();
+        return result;
+      }
 
-      getNextToken();
+      group g = groups.back();
+      if( g.callee < 0 )
+      {
+        if( currenttok != ')' )
+        {
+          LogError("CLOSING BRACKET ')' MISSING FOR THE EXPRESSION");
+          return fail();
+        }
+        // EAT ')', the bracketed expression is an operand of the enclosing group
+        getNextToken();
+        groups.pop_back();
+        continue;
+      }
+
+      arguments.push_back(operands.back());
+      operands.pop_back();
+      if( currenttok == ',' )
+      {
+        getNextToken();
+        break;
+      }
+      if( currenttok != ')' )
+      {
+        LogError("MISSING SEPERATOR ',' IN LIST OF ARGUMENTS");
+        return fail();
+      }
+      groups.pop_back();
+      finishcall(g);
     }
   }
-  // EAT ')'
-  getNextToken();
-  // EAT ';'
-  if( currenttok == ';' )
-  { getNextToken(); }
+}
 
-  return make_unique<callexpr>(identname, move(arguments));
+// NUMBEREXPR := NUMBER
+nodeid ParseNumberExpr()
+{
+  auto result = tree.add(nodekind::number, 0, value);
+  getNextToken();
+  return result;
 }
 
 // PRIMARY := BEGIN / END
-// PRIMARY := IDENTIFIEREXPR
+// PRIMARY := IDENTIFIER
 // PRIMARY := NUMBEREXPR
-// PRIMARY := PARENTEXPR
 // PRIMARY := IFEXPR
 // PRIMARY := FOREXPR
 // PRIMARY := VAREXPR
-unique_ptr<expression> ParsePrimary()
+nodeid ParsePrimary()
 {
   switch( currenttok )
   {
     default:
       if( currenttok == tok_begin || currenttok == tok_end )
-      { return nullptr; }
+      { return nonode; }
       return LogError("EXPECTED EXPRESSION MISSING");
     case( tok_identifier ):
-      return ParseIdentifierExpr();
+    {
+      auto result = tree.add(nodekind::variable, 0, idnum);
+      getNextToken();
+      return result;
+    }
     case( tok_number ):
       return ParseNumberExpr();
-    case( '(' ):
-      return ParseParentExpr();
     case( tok_if ):
       return ParseIfExpr();
     case( tok_for ):
@@ -175,41 +331,6 @@ unique_ptr<expression> ParsePrimary()
   }
 }
 
-// BINOPRHS := ( + PRIMARY )*
-unique_ptr<expression> ParseBinOpRHS(int ExprPrec, unique_ptr<expression> LHS)
-{
-  while( true )
-  {
-    // get the operator's precedence
-    int prec = GetTokPrecedence();
-    // If the operator is a binary operator that dosen't bind at least as tightly as the current binop
-    if( prec < ExprPrec )
-    { return LHS; }
-
-    // binary operator
-    int binop = currenttok;
-    getNextToken();
-
-    // Parse the primary expression after the binary operator
-    auto RHS = ParseUnary();
-    if( !RHS )
-    { return nullptr; }
-
-    // If the binary operator binds less tightly with the RHS than the operator after the RHS
-    // the pending operator takes the RHS as its LHS
-    int nextprec = GetTokPrecedence();
-    if( prec < nextprec )
-    {
-      RHS = ParseBinOpRHS(prec + 1, move(RHS));
-      if( !RHS )
-      { return nullptr; }
-    }
-
-    // Merge the LHS and RHS
-    LHS = make_unique<binexpr>(binop, move(LHS), move(RHS));
-  }
-}
-
 // PROTOTYPE := ID ( ID* )
 unique_ptr<funcproto> ParsePrototype()
 {
@@ -223,7 +344,7 @@ unique_ptr<funcproto> ParsePrototype()
   if( currenttok != tok_identifier )
   { return LogErrorP("MISSING FUNCTION NAME"); }
 
-  string funcname = idname;
+  string funcname(idname);
   getNextToken();
 
   if( currenttok != '(' )
@@ -232,7 +353,7 @@ unique_ptr<funcproto> ParsePrototype()
   vector<string> arguments;
   while( currenttok != ')' && getNextToken() == tok_identifier )
   {
-    arguments.push_back(idname);
+    arguments.emplace_back(idname);
     getNextToken();
     if( currenttok == ':' )
     { getNextToken(); }
@@ -274,6 +395,8 @@ unique_ptr<funct> ParseDefinition()
   auto proto = ParsePrototype();
   if( !proto )
   { return nullptr; }
+  // the keyword is already eaten, the prototype has to be told it returns void
+  proto->isprocedure = isproc;
 
   if( currenttok == ':' )
   {
@@ -296,7 +419,7 @@ unique_ptr<funct> ParseDefinition()
   if( currenttok == ';' )
   { getNextToken(); }
 
-  if( idname == "forward" )
+  if( currenttok == tok_forward )
   {
     getNextToken();
     if( currenttok == ';' )
@@ -308,10 +431,15 @@ unique_ptr<funct> ParseDefinition()
   { LogErrorP("EXPECTED 'begin'"); }
 
 
-  vector<unique_ptr<expression>> astexpr;
+  vector<nodeid> astexpr;
 
   if(currenttok == tok_var)
-  { astexpr.push_back(ParseExpression()); }
+  {
+    auto e = ParseExpression();
+    if( e == nonode )
+    { return nullptr; }
+    astexpr.push_back(e);
+  }
 
   if (currenttok == tok_begin)
   { getNextToken(); }
@@ -320,11 +448,12 @@ unique_ptr<funct> ParseDefinition()
   {
     if( currenttok == tok_end )
     { break; }
-    else if( auto e = ParseExpression() )
+    auto e = ParseExpression();
+    if( e != nonode )
     {
       if( currenttok == ';' )
       { getNextToken(); }
-      astexpr.push_back(move(e));
+      astexpr.push_back(e);
     }
     else
     {
@@ -333,21 +462,20 @@ unique_ptr<funct> ParseDefinition()
       return nullptr;
     }
   }
-  return make_unique<funct>(move(proto), move(astexpr), isproc);
+  uint32_t body = tree.addlist(astexpr);
+  return make_unique<funct>(move(proto), taketree(), body, isproc);
 }
 
 //TOPLEVELEXPR := EXPRESSION
 unique_ptr<funct> ParseTopLevelExpr()
 {
-  vector<unique_ptr<expression>> body;
-  if( auto e = ParseExpression() )
-  {
-    // New function prototype declared
-    auto proto = make_unique<funcproto>("main", vector<string>());
-    body.push_back(move(e));
-    return make_unique<funct>(move(proto), move(body), false);
-  }
-  return nullptr;
+  auto e = ParseExpression();
+  if( e == nonode )
+  { return nullptr; }
+  // New function prototype declared
+  auto proto = make_unique<funcproto>("main", vector<string>());
+  uint32_t body = tree.addlist({ e });
+  return make_unique<funct>(move(proto), taketree(), body, false);
 }
 
 //EXTERNAL := FUNCTION PROTOTYPE ( USER FUNCTIONS )
@@ -359,13 +487,13 @@ unique_ptr<funcproto> ParseExternal()
 
 
 // IFEXPR := IF / THEN / ELSE EXPRESSIONS
-unique_ptr<expression> ParseIfExpr()
+nodeid ParseIfExpr()
 {
   getNextToken();
 
   auto cond = ParseExpression();
-  if( !cond )
-  { return nullptr; }
+  if( cond == nonode )
+  { return nonode; }
 
   if( currenttok != tok_then )
   { return LogError("MISSING 'then'");}
@@ -378,14 +506,15 @@ unique_ptr<expression> ParseIfExpr()
     getNextToken();
   }
 
-  vector<unique_ptr<expression>> thenblock;
+  vector<nodeid> thenblock;
   while( currenttok != tok_end )
   {
-    if( auto e = ParseExpression() )
+    auto e = ParseExpression();
+    if( e != nonode )
     {
       if( currenttok == ';' )
       { getNextToken(); }
-      thenblock.push_back(move(e));
+      thenblock.push_back(e);
 
       if( !ifblock )
       { break; }
@@ -394,7 +523,7 @@ unique_ptr<expression> ParseIfExpr()
     {
       if( currenttok == tok_end )
       { break; }
-      return nullptr;
+      return nonode;
     }
   }
 
@@ -403,29 +532,26 @@ unique_ptr<expression> ParseIfExpr()
   if( ifblock )
   { getNextToken(); }
 
-  bool iselse = false;
+  nodeid elsee = nonode;
   if( currenttok == tok_else )
   {
-    iselse = true;
     getNextToken();
-    auto elsee = ParseExpression();
-    if( !elsee )
-    { return nullptr; }
-
-    return make_unique<ifexpr>(move(cond), move(thenblock), move(elsee), iselse);
+    elsee = ParseExpression();
+    if( elsee == nonode )
+    { return nonode; }
   }
 
-  return make_unique<ifexpr>(move(cond), move(thenblock));
+  return tree.add(nodekind::ifthen, 0, cond, tree.addlist(thenblock), elsee);
 }
 
 // FOREXPR := FOR IDENT = EXPR , EXPR (, EXPR) ? IN EXPR
-unique_ptr<expression> ParseForExpr()
+nodeid ParseForExpr()
 {
   getNextToken();
   if (currenttok != tok_identifier)
   { return LogError("MISSING 'identifier' AFTER THE 'for'"); }
 
-  string identname = idname;
+  int ident = idnum;
   getNextToken();
 
   if( currenttok != tok_assign )
@@ -434,8 +560,8 @@ unique_ptr<expression> ParseForExpr()
 
 
   auto start = ParseExpression();
-  if( !start )
-  { return nullptr; }
+  if( start == nonode )
+  { return nonode; }
 
   bool to;
   if( currenttok == tok_to )
@@ -447,10 +573,9 @@ unique_ptr<expression> ParseForExpr()
   getNextToken();
 
   auto end = ParseExpression();
-  if( !end )
-  { return nullptr; }
+  if( end == nonode )
+  { return nonode; }
 
-  unique_ptr<expression> step;
   if (currenttok == tok_do)
   { getNextToken(); }
   else
@@ -460,64 +585,45 @@ unique_ptr<expression> ParseForExpr()
   else
   { LogError("MISSING 'begin' AFTER 'for'"); }
 
-  vector<unique_ptr<expression>> body;
+  vector<nodeid> body;
   while (currenttok != tok_end)
   {
-    if( auto expr = ParseExpression() )
+    auto expr = ParseExpression();
+    if( expr != nonode )
     {
       if( currenttok == ';' )
       { getNextToken(); }
-      body.push_back(move(expr));
+      body.push_back(expr);
     }
     else
     {
       if( currenttok == tok_end )
-      {
-        getNextToken();
-        return make_unique<forexpr>(identname, move(start), move(end), move(step), move(body), to);
-      }
-      return nullptr;
+      { break; }
+      return nonode;
     }
   }
   if (currenttok == tok_end)
   { getNextToken(); }
 
-  return make_unique<forexpr>(identname, move(start), move(end), move(step), move(body), to);
-}
-
-// UNARY := PRIMARY
-// UNARY := !PRIMARY
-unique_ptr<expression> ParseUnary()
-{
-  // if the current token is not an operator its a primary expression
-  if( !isascii(currenttok) || currenttok == '(' || currenttok == ',' )
-  { return ParsePrimary(); }
-
-  int op = currenttok;
-  getNextToken();
-  if( auto operand = ParseUnary() )
-  { return make_unique<unaryexpr>(op, move(operand)); }
-  return nullptr;
+  return tree.add(nodekind::forloop, to, ident, start, end, tree.addlist(body));
 }
 
 // VAREXPR := VAR IDENTIFIER ( = EXPRESSION )?
 // VAREXPR := VAR (, IDENTIFIER ( = EXPRESSION )? )* IN EXPRESSION
-unique_ptr<expression> ParseVarExpr()
+nodeid ParseVarExpr()
 {
   getNextToken();
 
-  vector<pair<string, unique_ptr<expression>>> varnames;
+  vector<uint32_t> varnames;
 
   // At least one variable name
   if( currenttok != tok_identifier )
   {return LogError("EXPECTED AN 'identifier' AFTER 'var'");}
 
-  string name = idname;
+  varnames.push_back(idnum);
+  varnames.push_back(nonode);
   getNextToken();
 
-  unique_ptr<expression> init = nullptr;
-  varnames.emplace_back(name, move(init));
-
   if( currenttok == ':' )
   { HandleSequenceVars(varnames); }
   else if( currenttok == ',' )
@@ -525,15 +631,15 @@ unique_ptr<expression> ParseVarExpr()
   else
   { return LogError("MISSING ',' OR ':' AFTER THE 'identifier'"); }
 
-  return make_unique<varexpr>(move(varnames));
+  return tree.add(nodekind::vars, 0, tree.addlist(varnames));
 }
 
 // CONSTEXPR
-unique_ptr<expression> ParseConstExpr()
+nodeid ParseConstExpr()
 {
   getNextToken();
 
-  vector<pair<string, unique_ptr<expression>>> varnames;
+  vector<uint32_t> varnames;
 
   if (currenttok != tok_identifier)
   { return LogError("EXPECTING AN 'identifier' AFTER 'const'"); }
@@ -543,22 +649,22 @@ unique_ptr<expression> ParseConstExpr()
     if( currenttok != tok_identifier )
     { break; }
 
-    string name = idname;
-    constants.insert(idname);
+    int ident = idnum;
     getNextToken();
 
-    unique_ptr<expression> init = nullptr;
+    nodeid init = nonode;
     if (currenttok == '=')
     {
       getNextToken();
       init = ParseExpression();
-      if (!init)
-      { return nullptr; }
+      if( init == nonode )
+      { return nonode; }
     }
     else
     { return LogError("MISSING INITIALIZATION FOR THE CONSTANT"); }
 
-    varnames.emplace_back(name, move(init));
+    varnames.push_back(ident);
+    varnames.push_back(init);
     if( currenttok != ';' )
     { break; }
     getNextToken();
@@ -569,11 +675,11 @@ unique_ptr<expression> ParseConstExpr()
     { return LogError("MISSING 'identifier' list"); }
   }
 
-  return make_unique<constantexpr>(move(varnames));
+  return tree.add(nodekind::consts, 0, tree.addlist(varnames));
 }
 
 
-void InitializeModuleAndPassManager()
+void InitializeModuleAndPassManager( bool optimize )
 {
   // Create a new LLVM " MODULE "
   context = make_unique<LLVMContext>();
@@ -582,7 +688,10 @@ void InitializeModuleAndPassManager()
   // Create a new LLVM " BUILDER " for the " MODULE "
   builder = make_unique<IRBuilder<>>(*context);
 
-  // Create a new " FUNCTION PASS MANAGER " (FPM) attached to it
+  // Create a new " FUNCTION PASS MANAGER " (FPM) attached to it, -O0 keeps the functions as generated
+  fpm = nullptr;
+  if( !optimize )
+  { return; }
   fpm = make_unique<legacy::FunctionPassManager>(module.get());
 
   // Initialize the FPM
@@ -594,6 +703,10 @@ void InitializeModuleAndPassManager()
   fpm->doInitialization();
 }
 
+bool keepprogram = false;
+vector< unique_ptr< funct > > program;
+function< void( Function & ) > finishedfunction;
+
 void HandleDefinition()
 {
   if( auto func = ParseDefinition() )
@@ -601,17 +714,36 @@ void HandleDefinition()
     auto *check = func->codegen();
     // if( auto *check = func->codegen() )
     // { fprintf(stderr, "FUNCTION DEFINITION ERROR\n"); }
+    if( check && finishedfunction )
+    { finishedfunction(*check); }
+    if( check && keepprogram )
+    { program.push_back(move(func)); }
   }
   else
   { getNextToken(); }
+  // drop whatever a failed parse left behind
+  tree.clear();
 }
 
 void HandleTopLevelExpression()
 {
   if( auto func = ParseTopLevelExpr() )
-  { func->codegen(); }
+  {
+    if( func->codegen() )
+    {
+      if( keepprogram )
+      { program.push_back(move(func)); }
+    }
+    else if( keepprogram )
+    {
+      // the failed statement deleted the body of main, the statements before it went with it
+      program.erase(remove_if(program.begin(), program.end(), []( const unique_ptr< funct > & f )
+                    { return f->getproto().getname() == "main"; }), program.end());
+    }
+  }
   else
   { getNextToken(); }
+  tree.clear();
 }
 
 void writeln()
@@ -633,26 +765,32 @@ void readln()
 
 void HandleVarGlobal()
 {
-  if( auto func = ParseVarExpr() )
+  auto decl = ParseVarExpr();
+  if( decl != nonode )
   {
-    auto check = func->makeglobal();
-    // if( auto check = func->makeglobal())
+    aststats.record(tree);
+    auto check = makeglobal(tree, decl);
+    // if( auto check = makeglobal(tree, decl))
     // { fprintf(stderr, "VARIABLE DEFINITION ERROR\n"); }
   }
   else
   { getNextToken(); }
+  tree.clear();
 }
 
 void HandleConstVal()
 {
-  if( auto func = ParseConstExpr() )
+  auto decl = ParseConstExpr();
+  if( decl != nonode )
   {
-    auto check = func->makeglobal();
-    // if( auto check = func->makeglobal())
+    aststats.record(tree);
+    auto check = makeglobal(tree, decl);
+    // if( auto check = makeglobal(tree, decl))
     // { fprintf(stderr, "CONSTANT DEFINITION ERROR\n"); }
   }
   else
   { getNextToken(); }
+  tree.clear();
 }
 
 void HandleForward()
@@ -668,7 +806,7 @@ void HandleForward()
 }
 
 // VAR X : INTEGER; Y:INTEGER ;
-void HandleSequenceVars( vector<pair<string, unique_ptr<expression>>> & varnames )
+void HandleSequenceVars( vector<uint32_t> & varnames )
 {
   bool flag = true;
   while( true )
@@ -679,11 +817,9 @@ void HandleSequenceVars( vector<pair<string, unique_ptr<expression>>> & varnames
 
     if( !flag )
     {
-      string name = idname;
+      varnames.push_back(idnum);
+      varnames.push_back(nonode);
       getNextToken();
-
-      unique_ptr<expression> init = nullptr;
-      varnames.emplace_back(name, move(init));
     }
 
     if( currenttok == ':' )
@@ -713,7 +849,7 @@ void HandleSequenceVars( vector<pair<string, unique_ptr<expression>>> & varnames
 }
 
 // VAR X,Y : INTEGER;
-void HandleListVars( vector<pair<string, unique_ptr<expression>>> & varnames )
+void HandleListVars( vector<uint32_t> & varnames )
 {
   bool flag = true;
   while( true )
@@ -724,11 +860,9 @@ void HandleListVars( vector<pair<string, unique_ptr<expression>>> & varnames )
 
     if( !flag )
     {
-      string name = idname;
+      varnames.push_back(idnum);
+      varnames.push_back(nonode);
       getNextToken();
-
-      unique_ptr<expression> init = nullptr;
-      varnames.emplace_back(name, move(init));
     }
 
     // END OF THE VAR LIST
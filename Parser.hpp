@@ -21,8 +21,12 @@
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -59,35 +63,103 @@ public:
   const Module& Generate();
 };
 
-extern map<char, int> BinopPrecedence;
+// " OPERATOR TABLE " how every token behaves as an operator, indexed by ( token + tokenbias ) as the
+// tokens are ASCII charecters or the negative ( Token ) values
+struct operatorinfo
+{
+  // binding power as a built-in binary operator, 0 if the token isn't one
+  uint8_t precedence;
+  // a = b = c groups as a = ( b = c )
+  bool rightassoc;
+  // built-in prefix operator, codegen emits it directly
+  bool prefix;
+};
+
+const int tokenbias = 64;
+
+constexpr array< operatorinfo, 128 + tokenbias > makeoperatortable()
+{
+  array< operatorinfo, 128 + tokenbias > table {};
+  // assignment, ':=' is the same operator as '='
+  table['=' + tokenbias] = { 2, true, false };
+  table[tok_assign + tokenbias] = { 2, true, false };
+  // comparisons
+  table['<' + tokenbias] = { 10, false, false };
+  table['>' + tokenbias] = { 10, false, false };
+  table[tok_lessequal + tokenbias] = { 10, false, false };
+  table[tok_greaterequal + tokenbias] = { 10, false, false };
+  table[tok_notequal + tokenbias] = { 10, false, false };
+  table[tok_eq + tokenbias] = { 10, false, false };
+  // additive
+  table['+' + tokenbias] = { 20, false, false };
+  table['-' + tokenbias] = { 20, false, true };
+  table[tok_or + tokenbias] = { 20, false, false };
+  table[tok_xor + tokenbias] = { 20, false, false };
+  // multiplicative
+  table['*' + tokenbias] = { 40, false, false };
+  table['/' + tokenbias] = { 40, false, false };
+  table[tok_div + tokenbias] = { 40, false, false };
+  table[tok_mod + tokenbias] = { 40, false, false };
+  table[tok_and + tokenbias] = { 40, false, false };
+  // prefix only
+  table[tok_not + tokenbias] = { 0, false, true };
+  return table;
+}
+
+inline constexpr array< operatorinfo, 128 + tokenbias > operatortable = makeoperatortable();
+
+inline operatorinfo operatorof( int token )
+{
+  if( token < -tokenbias || token >= 128 )
+  { return operatorinfo {}; }
+  return operatortable[token + tokenbias];
+}
+
+// " USER OPERATORS " precedence of the ( binary ) operators the program defines, indexed by the charecter
+extern array< uint8_t, 256 > userprecedence;
+
 extern int currenttok;
+// the lexed program the parser walks through
+extern tokenstream tokens;
+// the AST of the top level item being parsed
+extern astbody tree;
 
-// Returns the next token in the stdin into the ( current token ) variable
+// Returns the next token of the token stream into the ( current token ) variable
 int getNextToken();
-// Returns the current token's precedence
+// Returns the token ( k ) positions after the current one without consuming anything
+int peektok( size_t k = 1 );
+// Index of the current token in the token stream
+size_t tokenindex();
+// Makes the token at ( index ) the current one, used to parse a range again
+void seektok( size_t index );
+// Returns the current token's precedence as a binary operator or -1
 int GetTokPrecedence();
 
 // Error logging (stderr)
-unique_ptr<expression> LogError(const char *str);
+nodeid LogError(const char *str);
+// number of errors logged so far, outputs of programs with errors aren't cached
+extern size_t errorcount;
 unique_ptr<funcproto> LogErrorP(const char *str);
 
-unique_ptr<expression> ParseExpression();
-unique_ptr<expression> ParseNumberExpr();
-unique_ptr<expression> ParseParentExpr();
-unique_ptr<expression> ParseIdentifierExpr();
-unique_ptr<expression> ParsePrimary();
-unique_ptr<expression> ParseBinOpRHS(int ExprPrec, unique_ptr<expression> LHS);
+nodeid ParseExpression();
+nodeid ParseNumberExpr();
+nodeid ParsePrimary();
 unique_ptr<funcproto> ParsePrototype();
 unique_ptr<funct> ParseDefinition();
 unique_ptr<funct> ParseTopLevelExpr();
 unique_ptr<funcproto> ParseExternal();
-unique_ptr<expression> ParseIfExpr();
-unique_ptr<expression> ParseForExpr();
-unique_ptr<expression> ParseUnary();
-unique_ptr<expression> ParseVarExpr();
-unique_ptr<expression> ParseConstExpr();
-
-void InitializeModuleAndPassManager();
+nodeid ParseIfExpr();
+nodeid ParseForExpr();
+nodeid ParseVarExpr();
+nodeid ParseConstExpr();
+
+// Creates the module and the builder, ( optimize ) enables the per function passes run as functions are finished
+void InitializeModuleAndPassManager( bool optimize = true );
+// every definition and top level statement that was generated, in source order, only kept if ( keepprogram ) is set
+extern bool keepprogram;
+extern vector< unique_ptr< funct > > program;
+// called with every function definition as soon as its codegen is done ( --pipeline )
+extern function< void( Function & ) > finishedfunction;
 
 void HandleDefinition();
 void HandleTopLevelExpression();
@@ -99,8 +171,9 @@ void HandleVarGlobal();
 void HandleConstVal();
 void HandleForward();
 
-void HandleSequenceVars( vector<pair<string, unique_ptr<expression>>> & varnames );
-void HandleListVars( vector<pair<string, unique_ptr<expression>>> & varnames );
+// both append ( identifier id, nonode ) pairs to ( varnames )
+void HandleSequenceVars( vector<uint32_t> & varnames );
+void HandleListVars( vector<uint32_t> & varnames );
 
 void MainLoop();
 
@@ -0,0 +1,215 @@
+#include "Pipeline.hpp"
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// " BOUNDED QUEUE " between two stages, push waits while it's full and pop while it's empty
+template< typename T >
+class boundedqueue
+{
+private:
+  mutex lock;
+  condition_variable changed;
+  deque< T > items;
+  size_t capacity;
+  bool closed;
+
+public:
+  explicit boundedqueue( size_t c ) : capacity(c), closed(false) {}
+
+  void push( T item )
+  {
+    unique_lock< mutex > guard(lock);
+    changed.wait(guard, [this] { return items.size() < capacity; });
+    items.push_back(move(item));
+    changed.notify_all();
+  }
+
+  // Returns false once the queue is closed and empty
+  bool pop( T & item )
+  {
+    unique_lock< mutex > guard(lock);
+    changed.wait(guard, [this] { return !items.empty() || closed; });
+    if( items.empty() )
+    { return false; }
+    item = move(items.front());
+    items.pop_front();
+    changed.notify_all();
+    return true;
+  }
+
+  // Nothing more is coming, the consumer stops once it took what's left
+  void close()
+  {
+    lock_guard< mutex > guard(lock);
+    closed = true;
+    changed.notify_all();
+  }
+};
+
+// an optimized part on its way to the emitter, the module goes before its context. Moving one member by member
+// would free the old context first, so the parts are only ever passed around whole behind a pointer
+struct optimizedpart
+{
+  unique_ptr< LLVMContext > context;
+  unique_ptr< Module > module;
+};
+
+struct pipelinestate
+{
+  targetspec target;
+  // finished functions not sent yet and their instructions
+  vector< const Function * > collected;
+  size_t instructions;
+
+  boundedqueue< string > bitcode;
+  boundedqueue< unique_ptr< optimizedpart > > optimized;
+  std::thread optimizer;
+  std::thread emitter;
+  // objects in the order the parts were sent, only the emitter adds to it until it's joined
+  vector< unique_ptr< MemoryBuffer > > objects;
+  // once set the stages only drain the queues so the parser never waits forever
+  atomic< bool > failed;
+  string optimizererror;
+  string emittererror;
+
+  pipelinestate( const targetspec & t, size_t depth ) :
+  target(t), instructions(0), bitcode(depth), optimized(depth), failed(false) {}
+  // a compilation that stops before the pipeline is finished still has to stop the threads
+  ~pipelinestate()
+  {
+    failed = true;
+    bitcode.close();
+    if( optimizer.joinable() )
+    { optimizer.join(); }
+    if( emitter.joinable() )
+    { emitter.join(); }
+  }
+};
+
+unique_ptr< pipelinestate > state;
+
+void optimizerloop( pipelinestate & s )
+{
+  unique_ptr< TargetMachine > machine = createmachine(s.target, s.optimizererror);
+  s.failed = s.failed || !machine;
+  string part;
+  while( s.bitcode.pop(part) )
+  {
+    if( s.failed )
+    { continue; }
+    auto next = make_unique<optimizedpart>();
+    next->context = make_unique<LLVMContext>();
+    auto parsed = parseBitcodeFile(MemoryBufferRef(part, "part"), *next->context);
+    if( !parsed )
+    {
+      s.optimizererror = toString(parsed.takeError());
+      s.failed = true;
+      continue;
+    }
+    Module & module = **parsed;
+    next->module = move(*parsed);
+    module.setDataLayout(machine->createDataLayout());
+    module.setTargetTriple(s.target.triple);
+    // the vectorizer's cost model and the instruction selection take the target from the attributes
+    for( Function & f : module )
+    {
+      if( f.isDeclaration() )
+      { continue; }
+      if( !s.target.cpu.empty() )
+      { f.addFnAttr("target-cpu", s.target.cpu); }
+      if( !s.target.features.empty() )
+      { f.addFnAttr("target-features", s.target.features); }
+    }
+    optimizemodule(module, machine.get(), s.target.level);
+    s.optimized.push(move(next));
+  }
+  s.optimized.close();
+}
+
+void emitterloop( pipelinestate & s )
+{
+  unique_ptr< TargetMachine > machine = createmachine(s.target, s.emittererror);
+  s.failed = s.failed || !machine;
+  unique_ptr< optimizedpart > part;
+  while( s.optimized.pop(part) )
+  {
+    if( s.failed )
+    { continue; }
+    auto object = emitobject(*part->module, *machine);
+    if( !object )
+    {
+      s.emittererror = "TheTargetMachine can't emit a file of this type";
+      s.failed = true;
+      continue;
+    }
+    s.objects.push_back(move(object));
+    // free the part here rather than when the next one replaces it
+    part.reset();
+  }
+}
+
+// Moves the collected functions out of ( module ) as one part and deletes their bodies
+void sendcollected( const Module & module, const Function * main )
+{
+  pipelinestate & s = *state;
+  if( main )
+  { s.collected.push_back(main); }
+  if( s.collected.empty() )
+  { return; }
+  string part = writebitcode(*extract(module, s.collected, main != nullptr));
+  // calls generated later only need the declarations that stay behind
+  for( const Function * f : s.collected )
+  { const_cast< Function * >(f)->deleteBody(); }
+  s.collected.clear();
+  s.instructions = 0;
+  s.bitcode.push(move(part));
+}
+
+}
+
+void startpipeline( const targetspec & target, size_t depth )
+{
+  state = make_unique<pipelinestate>(target, depth);
+  state->optimizer = std::thread(optimizerloop, ref(*state));
+  state->emitter = std::thread(emitterloop, ref(*state));
+}
+
+void pipelinefunction( Function & function )
+{
+  state->collected.push_back(&function);
+  state->instructions += function.getInstructionCount();
+  if( state->instructions >= partinstructions )
+  { sendcollected(*function.getParent(), nullptr); }
+}
+
+bool finishpipeline( const Module & module, const string & path )
+{
+  pipelinestate & s = *state;
+  sendcollected(module, module.getFunction("main"));
+  s.bitcode.close();
+  s.optimizer.join();
+  s.emitter.join();
+
+  bool compiled = !s.failed;
+  for( const string & error : { s.optimizererror, s.emittererror } )
+  {
+    if( !error.empty() )
+    { errs() << "Could not compile a part: " << error << "\n"; }
+  }
+  vector< string > names;
+  for( size_t i = 0; i < s.objects.size(); i++ )
+  { names.push_back("part" + to_string(i) + ".o"); }
+  compiled = compiled && writearchive(path, s.objects, names, Triple(s.target.triple));
+  state.reset();
+  return compiled;
+}
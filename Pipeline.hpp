@@ -0,0 +1,26 @@
+#ifndef PJPPROJECT_PIPELINE_HPP
+#define PJPPROJECT_PIPELINE_HPP
+
+#include "llvm/IR/Module.h"
+#include <string>
+
+#include "Split.hpp"
+
+using namespace llvm;
+using namespace std;
+
+// " PIPELINE " ( --pipeline ) compiles the functions while the rest of the program is still being parsed. The parser
+// hands every finished function over, once a part's worth of them is collected they are moved out of the module as
+// bitcode and their bodies deleted. An optimizer thread reads each part into an LLVMContext of its own and optimizes
+// it, an emitter thread compiles it to an object. The queues between the stages hold ( depth ) parts, a parser that
+// gets further ahead waits
+
+// Starts the optimizer and the emitter threads for ( target )
+void startpipeline( const targetspec & target, size_t depth = 4 );
+// Takes the finished definition ( function ) of the module being parsed
+void pipelinefunction( Function & function );
+// Sends main with the global variables and the functions still collected, waits for the stages and writes the
+// objects to ( path ) as an archive. Returns false if a part couldn't be compiled or the archive written
+bool finishpipeline( const Module & module, const string & path );
+
+#endif //PJPPROJECT_PIPELINE_HPP
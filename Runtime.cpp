@@ -0,0 +1,48 @@
+#include "Runtime.hpp"
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+
+// fcebitcode.inc is written by the build from fce.bc, the bytes of the bitcode separated by commas
+alignas(4) static const unsigned char bitcode[] = {
+#include "fcebitcode.inc"
+};
+
+StringRef runtimebitcode()
+{ return StringRef((const char *) bitcode, sizeof(bitcode)); }
+
+bool linkruntime( Module & module )
+{
+  auto runtime = parseBitcodeFile(MemoryBufferRef(runtimebitcode(), "fce.bc"), module.getContext());
+  if( !runtime )
+  {
+      errs() << "Could not read the runtime: " << toString(runtime.takeError()) << "\n";
+      return false;
+  }
+  // the C compiler may spell the host's triple in another way
+  (*runtime)->setTargetTriple(module.getTargetTriple());
+  (*runtime)->setDataLayout(module.getDataLayout());
+  // the functions get the CPU and the features of the program's ones later, the inliner only merges functions
+  // with the same target
+  for( Function & f : **runtime )
+  {
+      f.removeFnAttr("target-cpu");
+      f.removeFnAttr("target-features");
+      f.removeFnAttr("tune-cpu");
+  }
+
+  // only what the program calls, internal so nothing clashes with the C library and the unused rest goes away
+  bool failed = Linker::linkModules(module, move(*runtime), Linker::LinkOnlyNeeded,
+                                    []( Module & linked, const StringSet<> & names )
+                                    {
+                                      internalizeModule(linked, [&]( const GlobalValue & value )
+                                                        { return !value.hasName() || !names.count(value.getName()); });
+                                    });
+  if( failed )
+  { errs() << "Could not link the runtime\n"; }
+  return !failed;
+}
@@ -0,0 +1,21 @@
+#ifndef PJPPROJECT_RUNTIME_HPP
+#define PJPPROJECT_RUNTIME_HPP
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+using namespace std;
+
+// " RUNTIME " fce.c compiled to bitcode by the build and embedded in the compiler. It's linked into the program's
+// module before the passes run, writeln and readln become internal functions the inliner can merge into their
+// callers and the parts no program calls are dropped. Only for the host, the bitcode was compiled for it
+
+// The embedded bitcode, it belongs to the keys of the outputs that contain it
+StringRef runtimebitcode();
+
+// Links the functions of the runtime ( module ) calls into it with internal linkage, ( module ) needs its target
+// triple and data layout already. Returns false if the bitcode couldn't be read or linked, the reason goes to the stderr
+bool linkruntime( Module & module );
+
+#endif //PJPPROJECT_RUNTIME_HPP
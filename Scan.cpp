@@ -0,0 +1,449 @@
+#include "Scan.hpp"
+
+#include <cctype>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MILA_X86 1
+#endif
+
+// " SCALAR " kernels, one charecter at a time
+
+static const char * scalarskipspace( const char * p, const char * end, uint32_t & line, const char * & linestart )
+{
+  while( p < end && isspace((unsigned char) *p) )
+  {
+    if( *p++ == '\n' )
+    {
+      line++;
+      linestart = p;
+    }
+  }
+  return p;
+}
+
+static const char * scalarskipcomment( const char * p, const char * end )
+{
+  while( p < end && *p != '\n' && *p != '\r' )
+  { ++p; }
+  return p;
+}
+
+static const char * scalarskipalnum( const char * p, const char * end )
+{
+  while( p < end && isalnum((unsigned char) *p) )
+  { ++p; }
+  return p;
+}
+
+static const char * scalardecimal( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  while( p < end && isdigit((unsigned char) *p) )
+  { number = number * 10 + (*p++ - '0'); }
+  value = number;
+  return p;
+}
+
+// digits 8 and 9 are consumed but end the number of base 8
+static const char * scalaroctal( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  bool valid = true;
+  while( p < end && isdigit((unsigned char) *p) )
+  {
+    valid = valid && *p < '8';
+    if( valid )
+    { number = number * 8 + (*p - '0'); }
+    ++p;
+  }
+  value = number;
+  return p;
+}
+
+// value of a hexadecimal digit or -1
+static int hexdigit( char c )
+{
+  if( c >= '0' && c <= '9' )
+  { return c - '0'; }
+  if( c >= 'a' && c <= 'f' )
+  { return c - 'a' + 10; }
+  if( c >= 'A' && c <= 'F' )
+  { return c - 'A' + 10; }
+  return -1;
+}
+
+// letters past F are consumed but end the number of base 16
+static const char * scalarhex( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  bool valid = true;
+  while( p < end && isalnum((unsigned char) *p) )
+  {
+    int digit = hexdigit(*p);
+    valid = valid && digit >= 0;
+    if( valid )
+    { number = number * 16 + digit; }
+    ++p;
+  }
+  value = number;
+  return p;
+}
+
+// " SWAR " helpers, 8 charecters at a time in a 64-bit register
+
+static const uint64_t ones = 0x0101010101010101ull;
+static const uint64_t highs = 0x8080808080808080ull;
+
+static inline uint64_t load8( const char * p )
+{
+  uint64_t x;
+  memcpy(&x, p, 8);
+  return x;
+}
+
+// high bit set in every byte of ( x ) within [ lo, hi ], exact per byte for 1 <= lo <= hi <= 127
+static inline uint64_t inrange( uint64_t x, unsigned lo, unsigned hi )
+{
+  uint64_t low7 = x & ~highs;
+  uint64_t ge = low7 + ones * (128 - lo);
+  uint64_t le = ~(low7 + ones * (127 - hi));
+  return ge & le & ~x & highs;
+}
+
+// turns the high bits of the bytes into a bitmask, byte 0 ( the first charecter ) becomes bit 0
+static inline uint32_t compress( uint64_t m )
+{ return (uint32_t) ((((m >> 7) & ones) * 0x0102040810204080ull) >> 56); }
+
+static inline uint32_t swarspaces( const char * p )
+{
+  uint64_t x = load8(p);
+  return compress(inrange(x, '\t', '\r') | inrange(x, ' ', ' '));
+}
+static inline uint32_t swarnewlines( const char * p )
+{ return compress(inrange(load8(p), '\n', '\n')); }
+static inline uint32_t swarlinebreaks( const char * p )
+{
+  uint64_t x = load8(p);
+  return compress(inrange(x, '\n', '\n') | inrange(x, '\r', '\r'));
+}
+static inline uint32_t swaralnums( const char * p )
+{
+  uint64_t x = load8(p);
+  return compress(inrange(x, '0', '9') | inrange(x, 'A', 'Z') | inrange(x, 'a', 'z'));
+}
+
+// Combines 8 digits of base ( B ), one per byte with the most significant in byte 0, into their value
+template< uint64_t B >
+static inline unsigned combine( uint64_t digits )
+{
+  digits = (digits * B + (digits >> 8)) & 0x00FF00FF00FF00FFull;
+  digits = (digits * (B * B) + (digits >> 16)) & 0x0000FFFF0000FFFFull;
+  digits = (digits * (B * B * B * B) + (digits >> 32)) & 0xFFFFFFFFull;
+  return (unsigned) digits;
+}
+
+// number of leading decimal digits in the 8 charecters of ( x )
+static inline int decimalrun( uint64_t x )
+{
+  // a borrow or carry only ever reaches bytes after the first non digit
+  uint64_t bad = ((x + ones * 0x46) | (x - ones * '0')) & highs;
+  return bad ? __builtin_ctzll(bad) / 8 : 8;
+}
+
+// the first ( n ) digits of ( x ) as a value, 1 <= n <= 8
+template< uint64_t B >
+static inline unsigned leadingdigits( uint64_t x, int n )
+{ return combine<B>((x - ones * '0') << (8 * (8 - n))); }
+
+static const unsigned powers10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+static const char * swardecimal( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  while( end - p >= 8 )
+  {
+    uint64_t x = load8(p);
+    int n = decimalrun(x);
+    if( n == 0 )
+    {
+      value = number;
+      return p;
+    }
+    number = number * powers10[n] + leadingdigits<10>(x, n);
+    p += n;
+    if( n < 8 )
+    {
+      value = number;
+      return p;
+    }
+  }
+  while( p < end && isdigit((unsigned char) *p) )
+  { number = number * 10 + (*p++ - '0'); }
+  value = number;
+  return p;
+}
+
+static const char * swaroctal( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  bool valid = true;
+  while( end - p >= 8 )
+  {
+    uint64_t x = load8(p);
+    int n = decimalrun(x);
+    if( n == 0 )
+    {
+      value = number;
+      return p;
+    }
+    if( valid )
+    {
+      // bytes that aren't '0' - '7' have a nonzero byte in ( t )
+      uint64_t t = (x & (ones * 0xF8)) ^ (ones * '0');
+      uint64_t bad = (t | ((t & ~highs) + ~highs)) & highs;
+      int k = bad ? __builtin_ctzll(bad) / 8 : 8;
+      if( k > n )
+      { k = n; }
+      if( k > 0 )
+      { number = (number << (3 * k)) + leadingdigits<8>(x, k); }
+      valid = k == n;
+    }
+    p += n;
+    if( n < 8 )
+    {
+      value = number;
+      return p;
+    }
+  }
+  while( p < end && isdigit((unsigned char) *p) )
+  {
+    valid = valid && *p < '8';
+    if( valid )
+    { number = number * 8 + (*p - '0'); }
+    ++p;
+  }
+  value = number;
+  return p;
+}
+
+// hexadecimal digit values, 16 for other alphanumerics and 17 for everything else
+static const struct hextable
+{
+  unsigned char value[256];
+  hextable()
+  {
+    for( int c = 0; c < 256; c++ )
+    {
+      int d = hexdigit((char) c);
+      value[c] = d >= 0 ? d : ( isalnum(c) ? 16 : 17 );
+    }
+  }
+} hexdigits;
+
+static const char * tablehex( const char * p, const char * end, unsigned & value )
+{
+  unsigned number = 0;
+  while( p < end && hexdigits.value[(unsigned char) *p] < 16 )
+  { number = number * 16 + hexdigits.value[(unsigned char) *p++]; }
+  // the rest of the alphanumerics after the first letter past F
+  while( p < end && hexdigits.value[(unsigned char) *p] < 17 )
+  { ++p; }
+  value = number;
+  return p;
+}
+
+// " BLOCK LOOPS " shared by every instruction set, ( block ) classifies ( block::width ) charecters
+// at a time into bitmasks with bit i set for charecter i
+
+template< class block >
+static inline const char * blockskipspace( const char * p, const char * end, uint32_t & line, const char * & linestart )
+{
+  while( end - p >= block::width )
+  {
+    uint32_t stop = ~block::spaces(p) & block::all;
+    // newlines before the first non whitespace
+    uint32_t newlines = block::newlines(p) & ( stop ? (stop & -stop) - 1 : block::all );
+    if( newlines )
+    {
+      line += __builtin_popcount(newlines);
+      linestart = p + (31 - __builtin_clz(newlines)) + 1;
+    }
+    if( stop )
+    { return p + __builtin_ctz(stop); }
+    p += block::width;
+  }
+  return scalarskipspace(p, end, line, linestart);
+}
+
+template< class block >
+static inline const char * blockskipcomment( const char * p, const char * end )
+{
+  while( end - p >= block::width )
+  {
+    if( uint32_t stop = block::linebreaks(p) )
+    { return p + __builtin_ctz(stop); }
+    p += block::width;
+  }
+  return scalarskipcomment(p, end);
+}
+
+template< class block >
+static inline const char * blockskipalnum( const char * p, const char * end )
+{
+  while( end - p >= block::width )
+  {
+    if( uint32_t stop = ~block::alnums(p) & block::all )
+    { return p + __builtin_ctz(stop); }
+    p += block::width;
+  }
+  return scalarskipalnum(p, end);
+}
+
+struct swarblock
+{
+  static const int width = 8;
+  static const uint32_t all = 0xFF;
+  static uint32_t spaces( const char * p ) { return swarspaces(p); }
+  static uint32_t newlines( const char * p ) { return swarnewlines(p); }
+  static uint32_t linebreaks( const char * p ) { return swarlinebreaks(p); }
+  static uint32_t alnums( const char * p ) { return swaralnums(p); }
+};
+
+static const char * swarskipspace( const char * p, const char * end, uint32_t & line, const char * & linestart )
+{ return blockskipspace<swarblock>(p, end, line, linestart); }
+static const char * swarskipcomment( const char * p, const char * end )
+{ return blockskipcomment<swarblock>(p, end); }
+static const char * swarskipalnum( const char * p, const char * end )
+{ return blockskipalnum<swarblock>(p, end); }
+
+#ifdef MILA_X86
+
+// " SSE2 " 16 charecters at a time
+
+#define MILA_SSE2 __attribute__((target("sse2")))
+
+// bytes of ( x ) within [ lo, hi ] as unsigned values
+MILA_SSE2 static inline __m128i inrange16( __m128i x, char lo, char hi )
+{
+  __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(hi - lo)), shifted);
+}
+
+struct sse2block
+{
+  static const int width = 16;
+  static const uint32_t all = 0xFFFF;
+  MILA_SSE2 static uint32_t spaces( const char * p )
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) p);
+    return _mm_movemask_epi8(_mm_or_si128(inrange16(x, '\t', '\r'), _mm_cmpeq_epi8(x, _mm_set1_epi8(' '))));
+  }
+  MILA_SSE2 static uint32_t newlines( const char * p )
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) p);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+  }
+  MILA_SSE2 static uint32_t linebreaks( const char * p )
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) p);
+    return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+  }
+  MILA_SSE2 static uint32_t alnums( const char * p )
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) p);
+    __m128i letters = inrange16(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+    return _mm_movemask_epi8(_mm_or_si128(letters, inrange16(x, '0', '9')));
+  }
+};
+
+// flatten pulls the block loops and the classifiers into one function compiled for the instruction set
+MILA_SSE2 __attribute__((flatten)) static const char * sse2skipspace( const char * p, const char * end, uint32_t & line, const char * & linestart )
+{ return blockskipspace<sse2block>(p, end, line, linestart); }
+MILA_SSE2 __attribute__((flatten)) static const char * sse2skipcomment( const char * p, const char * end )
+{ return blockskipcomment<sse2block>(p, end); }
+MILA_SSE2 __attribute__((flatten)) static const char * sse2skipalnum( const char * p, const char * end )
+{ return blockskipalnum<sse2block>(p, end); }
+
+// " AVX2 " 32 charecters at a time
+
+#define MILA_AVX2 __attribute__((target("avx2")))
+
+MILA_AVX2 static inline __m256i inrange32( __m256i x, char lo, char hi )
+{
+  __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(hi - lo)), shifted);
+}
+
+struct avx2block
+{
+  static const int width = 32;
+  static const uint32_t all = 0xFFFFFFFF;
+  MILA_AVX2 static uint32_t spaces( const char * p )
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) p);
+    return _mm256_movemask_epi8(_mm256_or_si256(inrange32(x, '\t', '\r'), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '))));
+  }
+  MILA_AVX2 static uint32_t newlines( const char * p )
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) p);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')));
+  }
+  MILA_AVX2 static uint32_t linebreaks( const char * p )
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) p);
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')),
+                                                _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r'))));
+  }
+  MILA_AVX2 static uint32_t alnums( const char * p )
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) p);
+    __m256i letters = inrange32(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+    return _mm256_movemask_epi8(_mm256_or_si256(letters, inrange32(x, '0', '9')));
+  }
+};
+
+MILA_AVX2 __attribute__((flatten)) static const char * avx2skipspace( const char * p, const char * end, uint32_t & line, const char * & linestart )
+{ return blockskipspace<avx2block>(p, end, line, linestart); }
+MILA_AVX2 __attribute__((flatten)) static const char * avx2skipcomment( const char * p, const char * end )
+{ return blockskipcomment<avx2block>(p, end); }
+MILA_AVX2 __attribute__((flatten)) static const char * avx2skipalnum( const char * p, const char * end )
+{ return blockskipalnum<avx2block>(p, end); }
+
+#endif
+
+// " KERNEL SETS "
+
+static const scankernels scalar = { "scalar", scalarskipspace, scalarskipcomment, scalarskipalnum,
+                                    scalardecimal, scalaroctal, scalarhex };
+static const scankernels swar = { "swar", swarskipspace, swarskipcomment, swarskipalnum,
+                                  swardecimal, swaroctal, tablehex };
+#ifdef MILA_X86
+static const scankernels sse2 = { "sse2", sse2skipspace, sse2skipcomment, sse2skipalnum,
+                                  swardecimal, swaroctal, tablehex };
+static const scankernels avx2 = { "avx2", avx2skipspace, avx2skipcomment, avx2skipalnum,
+                                  swardecimal, swaroctal, tablehex };
+#endif
+
+const scankernels & scalarkernels()
+{ return scalar; }
+
+vector< const scankernels * > supportedkernels()
+{
+  vector< const scankernels * > sets = { &scalar, &swar };
+#ifdef MILA_X86
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("sse2") )
+  { sets.push_back(&sse2); }
+  if( __builtin_cpu_supports("avx2") )
+  { sets.push_back(&avx2); }
+#endif
+  return sets;
+}
+
+const scankernels & bestkernels()
+{
+  static const scankernels * best = supportedkernels().back();
+  return *best;
+}
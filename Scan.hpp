@@ -0,0 +1,32 @@
+#ifndef PJPPROJECT_SCAN_HPP
+#define PJPPROJECT_SCAN_HPP
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// " SCANNING KERNELS " the inner loops of the lexer over runs of charecters, one set per instruction set.
+// every function gets a range [ p, end ) and returns the position where the run stops
+struct scankernels
+{
+  const char * name;
+  // skips whitespaces, every '\n' skipped increments ( line ) and moves ( linestart ) past it
+  const char * (*skipspace)( const char * p, const char * end, uint32_t & line, const char * & linestart );
+  // skips the body of a '#' comment, stops at '\n' or '\r'
+  const char * (*skipcomment)( const char * p, const char * end );
+  // skips the rest of an identifier [A-Z][a-z][0-9]
+  const char * (*skipalnum)( const char * p, const char * end );
+  // number literals, ( p ) points past the '&' / '$' prefix, the value wraps around on overflow
+  const char * (*parsedecimal)( const char * p, const char * end, unsigned & value );
+  const char * (*parseoctal)( const char * p, const char * end, unsigned & value );
+  const char * (*parsehex)( const char * p, const char * end, unsigned & value );
+};
+
+// charecter at a time reference kernels
+const scankernels & scalarkernels();
+// the fastest kernels the CPU supports ( AVX2, SSE2 or portable 64-bit SWAR ), picked on the first call
+const scankernels & bestkernels();
+// every kernel set the CPU supports, the scalar one first
+vector< const scankernels * > supportedkernels();
+
+#endif //PJPPROJECT_SCAN_HPP
@@ -0,0 +1,213 @@
+#include "Server.hpp"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Targets.hpp"
+
+using namespace llvm;
+
+// Contents of the file ( path ), empty if there is none
+static string readwhole( const Twine & path )
+{
+  auto buffer = MemoryBuffer::getFile(path);
+  return buffer ? string((*buffer)->getBuffer()) : string();
+}
+
+// " SERVING " one request in the forked process. The compilation runs in a directory of its own with the source
+// written to it, the stdout and the stderr go to files next to it, whatever else appears in the directory is the output
+static int serve( int connection, int (*compile)( int argc, char * argv[] ) )
+{
+  uint64_t count;
+  vector< string > arguments;
+  string input;
+  string text;
+  if( !receivenumber(connection, count) )
+  { return 1; }
+  arguments.resize(count);
+  for( string & argument : arguments )
+  {
+    if( !receivestring(connection, argument) )
+    { return 1; }
+  }
+  if( !receivestring(connection, input) || !receivestring(connection, text) )
+  { return 1; }
+  // only a plain name, the client never sends a path
+  if( input != sys::path::filename(input) || input == "." || input == ".." )
+  { return 1; }
+
+  SmallString<128> prefix;
+  sys::path::system_temp_directory(true, prefix);
+  sys::path::append(prefix, "mila-server");
+  SmallString<128> directory;
+  if( sys::fs::createUniqueDirectory(prefix, directory) )
+  { return 1; }
+  string base(directory.str());
+  string work = base + "/work";
+  string sourcepath = input.empty() ? base + "/stdin" : work + "/" + input;
+  string outpath = base + "/stdout";
+  string errpath = base + "/stderr";
+  bool prepared = !sys::fs::create_directory(work);
+  if( prepared )
+  {
+    error_code EC;
+    raw_fd_ostream out(sourcepath, EC, sys::fs::OF_None);
+    out << text;
+    prepared = !EC && !out.has_error();
+  }
+  text.clear();
+
+  int exitcode = 1;
+  if( prepared )
+  {
+    int in = open(sourcepath.c_str(), O_RDONLY);
+    int out = open(outpath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    int err = open(errpath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    prepared = in >= 0 && out >= 0 && err >= 0 && chdir(work.c_str()) == 0;
+    if( prepared )
+    {
+      if( input.empty() )
+      { dup2(in, STDIN_FILENO); }
+      dup2(out, STDOUT_FILENO);
+      dup2(err, STDERR_FILENO);
+      vector< char * > argv{ const_cast< char * >("mila") };
+      for( string & argument : arguments )
+      { argv.push_back(&argument[0]); }
+      if( !input.empty() )
+      { argv.push_back(&input[0]); }
+      argv.push_back(nullptr);
+      exitcode = compile(argv.size() - 1, argv.data());
+      outs().flush();
+      fflush(nullptr);
+    }
+  }
+
+  string output;
+  string name;
+  error_code EC;
+  for( sys::fs::directory_iterator entry(work, EC), end; !EC && entry != end; entry.increment(EC) )
+  {
+    StringRef file = sys::path::filename(entry->path());
+    if( file == input )
+    { continue; }
+    name = string(file);
+    output = readwhole(entry->path());
+    break;
+  }
+  bool answered = sendnumber(connection, (uint64_t) (int64_t) exitcode) && sendstring(connection, name) &&
+                  sendstring(connection, output) && sendstring(connection, readwhole(outpath)) &&
+                  sendstring(connection, readwhole(errpath));
+  sys::fs::remove_directories(base);
+  return answered ? 0 : 1;
+}
+
+// Creates the directory of the socket ( path ) for the user alone if there's none. Another user mustn't be able to
+// replace the socket in it, false with the reason on the stderr if one could
+static bool socketdirectory( const string & path )
+{
+  SmallString<128> directory(sys::path::parent_path(path));
+  if( directory.empty() )
+  { directory = "."; }
+  if( mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST )
+  {
+    errs() << "Could not create the directory of the socket: " << directory << ": " << strerror(errno) << "\n";
+    return false;
+  }
+  struct stat info;
+  if( lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) ||
+      ( info.st_uid != getuid() && info.st_uid != 0 ) || ( ( info.st_mode & 022 ) && !( info.st_mode & S_ISVTX ) ) )
+  {
+    errs() << "Other users can change the directory of the socket: " << directory << "\n";
+    return false;
+  }
+  return true;
+}
+
+int runserver( const string & path, int (*compile)( int argc, char * argv[] ) )
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if( path.size() >= sizeof(address.sun_path) )
+  {
+    errs() << "The socket path is too long: " << path << "\n";
+    return 1;
+  }
+  memcpy(address.sun_path, path.c_str(), path.size());
+  if( !socketdirectory(path) )
+  { return 1; }
+  // a socket some other server still listens on stays, one left behind by a server that was killed is replaced
+  int running = connectto(path);
+  if( running >= 0 )
+  {
+    close(running);
+    errs() << "A server is already listening on: " << path << "\n";
+    return 1;
+  }
+  unlink(path.c_str());
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if( listener < 0 || bind(listener, (const sockaddr *) &address, sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0 )
+  {
+    errs() << "Could not listen on: " << path << ": " << strerror(errno) << "\n";
+    return 1;
+  }
+  chmod(path.c_str(), 0600);
+
+  // the host's backend is set up once, the forked processes start with it done and set up the one of another
+  // --target themselves
+  string error;
+  if( !initializetarget(sys::getDefaultTargetTriple(), error) )
+  {
+    errs() << "errors: " << error << "\n";
+    return 1;
+  }
+  // the client's environment decides about the cache, not the server's
+  unsetenv("MILA_CACHE_DIR");
+  // the kernel reaps the finished processes
+  signal(SIGCHLD, SIG_IGN);
+  errs() << "mila: serving on " << path << "\n";
+
+  while( true )
+  {
+    int connection = accept(listener, nullptr, nullptr);
+    if( connection < 0 )
+    {
+      if( errno == EINTR || errno == ECONNABORTED )
+      { continue; }
+      errs() << "Could not accept a connection: " << strerror(errno) << "\n";
+      return 1;
+    }
+    // only the user's own clients
+    if( !sameuser(connection) )
+    {
+      close(connection);
+      continue;
+    }
+    pid_t child = fork();
+    if( child == 0 )
+    {
+      close(listener);
+      // a compilation waits for the linker it starts
+      signal(SIGCHLD, SIG_DFL);
+      _exit(serve(connection, compile));
+    }
+    if( child < 0 )
+    { errs() << "Could not start a compilation: " << strerror(errno) << "\n"; }
+    close(connection);
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef PJPPROJECT_SERVER_HPP
+#define PJPPROJECT_SERVER_HPP
+
+#include <string>
+
+#include "Client.hpp"
+
+using namespace std;
+
+// " COMPILE SERVER " ( --server ) sets up the targets once and compiles for the clients connecting to its Unix domain
+// socket. The compiler keeps the program in global state, so each request is served by a process forked from the
+// warm server: requests run concurrently, none of them pays for the setup and none sees the state of another
+
+// Serves ( compile ) on the socket ( path ), returns only if the socket couldn't be set up
+int runserver( const string & path, int (*compile)( int argc, char * argv[] ) );
+
+#endif //PJPPROJECT_SERVER_HPP
@@ -0,0 +1,90 @@
+#include "Source.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+sourcebuffer source;
+
+sourcebuffer::~sourcebuffer()
+{
+  if( mapped )
+  { munmap(const_cast<char *>(data), length); }
+}
+
+// Maps a regular file into memory, fails for pipes and terminals
+bool sourcebuffer::mapfd( int fd )
+{
+  struct stat st;
+  if( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) )
+  { return false; }
+
+  // mmap refuses empty mappings, an empty program is just an empty buffer
+  if( st.st_size == 0 )
+  {
+    data = storage.data();
+    length = 0;
+    return true;
+  }
+
+  void * addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if( addr == MAP_FAILED )
+  { return false; }
+  // the lexer walks the buffer front to back exactly once
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+  data = static_cast<const char *>(addr);
+  length = st.st_size;
+  mapped = true;
+  return true;
+}
+
+// Reads everything from the descriptor into ( storage ) using large blocks
+bool sourcebuffer::readfd( int fd )
+{
+  static const size_t block = 1 << 16;
+  size_t used = 0;
+  while( true )
+  {
+    storage.resize(used + block);
+    ssize_t got = read(fd, &storage[used], block);
+    // a signal interrupted the read before anything arrived
+    if( got < 0 && errno == EINTR )
+    { continue; }
+    if( got < 0 )
+    { return false; }
+    if( got == 0 )
+    { break; }
+    used += got;
+  }
+  storage.resize(used);
+
+  data = storage.data();
+  length = used;
+  return true;
+}
+
+bool sourcebuffer::openfile( const char * path )
+{
+  int fd = open(path, O_RDONLY);
+  if( fd < 0 )
+  { return false; }
+
+  bool ok = mapfd(fd) || readfd(fd);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  return ok;
+}
+
+bool sourcebuffer::openstdin()
+{ return mapfd(STDIN_FILENO) || readfd(STDIN_FILENO); }
+
+// " GETTERS "
+const char * sourcebuffer::begin() const
+{ return data; }
+const char * sourcebuffer::end() const
+{ return data + length; }
+size_t sourcebuffer::size() const
+{ return length; }
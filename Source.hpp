@@ -0,0 +1,44 @@
+#ifndef PJPPROJECT_SOURCE_HPP
+#define PJPPROJECT_SOURCE_HPP
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
+// " SOURCE BUFFER " holds the whole program text in one contiguous block of memory,
+// either memory-mapped from a file or read from the stdin in one go
+class sourcebuffer
+{
+private:
+  const char * data;
+  size_t length;
+  // set if ( data ) points to a memory mapping that has to be unmapped
+  bool mapped;
+  // backing storage for inputs that can't be mapped ( pipes, terminals )
+  string storage;
+
+  bool mapfd( int fd );
+  bool readfd( int fd );
+
+public:
+  // " CONSTRUCTOR "
+  sourcebuffer() : data(nullptr), length(0), mapped(false) {}
+  ~sourcebuffer();
+  sourcebuffer( const sourcebuffer & ) = delete;
+  sourcebuffer & operator=( const sourcebuffer & ) = delete;
+
+  // Maps the file at ( path ) into memory
+  bool openfile( const char * path );
+  // Maps the stdin if it is a regular file, otherwise reads it whole into memory
+  bool openstdin();
+
+  // " GETTERS "
+  const char * begin() const;
+  const char * end() const;
+  size_t size() const;
+};
+
+// the program being compiled
+extern sourcebuffer source;
+
+#endif //PJPPROJECT_SOURCE_HPP
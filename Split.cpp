@@ -0,0 +1,220 @@
+#include "Split.hpp"
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Object/ArchiveWriter.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Declares ( value ) in ( part ) and maps it to the declaration, global variables keep their initializers
+// if ( withglobals )
+static void declare( Module & part, const GlobalValue * value, bool withglobals, ValueToValueMapTy & map )
+{
+  if( map.count(value) )
+  { return; }
+  if( auto * f = dyn_cast< Function >(value) )
+  {
+    Function * declaration = Function::Create(f->getFunctionType(), GlobalValue::ExternalLinkage, f->getName(), &part);
+    declaration->copyAttributesFrom(f);
+    map[f] = declaration;
+  }
+  else if( auto * g = dyn_cast< GlobalVariable >(value) )
+  {
+    auto * copy = new GlobalVariable(part, g->getValueType(), g->isConstant(), GlobalValue::ExternalLinkage,
+                                     withglobals && g->hasInitializer() ? const_cast< Constant * >(g->getInitializer()) : nullptr,
+                                     g->getName());
+    map[g] = copy;
+  }
+}
+
+unique_ptr< Module > extract( const Module & module, ArrayRef< const Function * > functions, bool withglobals )
+{
+  auto part = make_unique<Module>(functions.front()->getName(), module.getContext());
+  part->setDataLayout(module.getDataLayout());
+  part->setTargetTriple(module.getTargetTriple());
+
+  // the definitions first so the calls between them don't get declarations
+  ValueToValueMapTy map;
+  for( const Function * f : functions )
+  { map[f] = Function::Create(f->getFunctionType(), f->getLinkage(), f->getName(), part.get()); }
+  if( withglobals )
+  {
+    for( const GlobalVariable & g : module.globals() )
+    { declare(*part, &g, true, map); }
+  }
+  for( const Function * f : functions )
+  {
+    for( const Instruction & i : instructions(*f) )
+    {
+      for( const Value * operand : i.operands() )
+      {
+        if( auto * value = dyn_cast< GlobalValue >(operand) )
+        { declare(*part, value, withglobals, map); }
+      }
+    }
+  }
+
+  for( const Function * f : functions )
+  {
+    auto * copy = cast< Function >(map[f]);
+    auto argument = copy->arg_begin();
+    for( const Argument & a : f->args() )
+    { map[&a] = &*argument++; }
+    SmallVector< ReturnInst *, 4 > returns;
+#if LLVM_VERSION_MAJOR >= 13
+    CloneFunctionInto(copy, f, map, CloneFunctionChangeType::DifferentModule, returns);
+#else
+    CloneFunctionInto(copy, f, map, true, returns);
+#endif
+  }
+  // cloning into another module adds the list of compile units even without any debug info, reading the part
+  // back would strip it and warn about invalid debug info
+  NamedMDNode * units = part->getNamedMetadata("llvm.dbg.cu");
+  if( units && units->getNumOperands() == 0 )
+  { part->eraseNamedMetadata(units); }
+  return part;
+}
+
+string writebitcode( const Module & part )
+{
+  string bitcode;
+  raw_string_ostream out(bitcode);
+  WriteBitcodeToFile(part, out);
+  return out.str();
+}
+
+unique_ptr< TargetMachine > createmachine( const targetspec & target, string & error )
+{
+  const Target * found = TargetRegistry::lookupTarget(target.triple, error);
+  if( !found )
+  { return nullptr; }
+  TargetOptions opt;
+  return unique_ptr< TargetMachine >(found->createTargetMachine(target.triple, target.cpu, target.features, opt,
+                                                                Optional<Reloc::Model>(), None, codegenlevel(target.level)));
+}
+
+unique_ptr< MemoryBuffer > emitobject( Module & part, TargetMachine & machine )
+{
+  SmallVector< char, 0 > buffer;
+  raw_svector_ostream out(buffer);
+  legacy::PassManager pass;
+  if( machine.addPassesToEmitFile(pass, out, nullptr, CGFT_ObjectFile) )
+  { return nullptr; }
+  pass.run(part);
+  return MemoryBuffer::getMemBufferCopy(StringRef(buffer.data(), buffer.size()));
+}
+
+bool compileparallel( const vector< string > & parts, const targetspec & target, unsigned jobs,
+                      vector< unique_ptr< MemoryBuffer > > & objects )
+{
+  objects.clear();
+  objects.resize(parts.size());
+  if( jobs == 0 )
+  { jobs = std::thread::hardware_concurrency(); }
+  jobs = max(1u, min(jobs, (unsigned) parts.size()));
+
+  // the threads take the next part in turn, the errors are printed once all of them are done
+  atomic< size_t > next(0);
+  atomic< bool > failed(false);
+  vector< string > errors(jobs);
+  auto worker = [&]( unsigned id ) {
+    string & error = errors[id];
+    unique_ptr< TargetMachine > machine = createmachine(target, error);
+    if( !machine )
+    {
+      failed = true;
+      return;
+    }
+    for( size_t i; !failed && ( i = next++ ) < parts.size(); )
+    {
+      LLVMContext context;
+      auto part = parseBitcodeFile(MemoryBufferRef(parts[i], "part"), context);
+      if( !part )
+      {
+        error = toString(part.takeError());
+        failed = true;
+        return;
+      }
+      optimizemodule(**part, machine.get(), target.level);
+      objects[i] = emitobject(**part, *machine);
+      if( !objects[i] )
+      {
+        error = "TheTargetMachine can't emit a file of this type";
+        failed = true;
+        return;
+      }
+    }
+  };
+
+  vector< std::thread > threads;
+  for( unsigned id = 1; id < jobs; id++ )
+  { threads.emplace_back(worker, id); }
+  worker(0);
+  for( auto & t : threads )
+  { t.join(); }
+
+  for( const string & error : errors )
+  {
+    if( !error.empty() )
+    { errs() << "Could not compile a part: " << error << "\n"; }
+  }
+  return !failed;
+}
+
+bool writearchive( const string & path, const vector< unique_ptr< MemoryBuffer > > & objects,
+                   const vector< string > & names, const Triple & triple )
+{
+  vector< NewArchiveMember > members;
+  for( size_t i = 0; i < objects.size(); i++ )
+  { members.emplace_back(MemoryBufferRef(objects[i]->getBuffer(), names[i])); }
+  auto kind = triple.isOSDarwin() ? object::Archive::K_DARWIN : object::Archive::K_GNU;
+  if( Error error = writeArchive(path, members, true, kind, true, false) )
+  {
+    errs() << "Could not write the archive: " << path << ": " << toString(move(error)) << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool emitsplit( const Module & module, const targetspec & target, unsigned jobs, const string & path )
+{
+  // consecutive functions in module order, the part holding main defines the global variables
+  vector< vector< const Function * > > groups(1);
+  size_t instructions = 0;
+  for( const Function & f : module )
+  {
+    if( f.isDeclaration() )
+    { continue; }
+    if( instructions >= partinstructions )
+    {
+      groups.emplace_back();
+      instructions = 0;
+    }
+    groups.back().push_back(&f);
+    instructions += f.getInstructionCount();
+  }
+
+  // the parts leave the context of the parser as bitcode
+  vector< string > parts;
+  vector< string > names;
+  for( auto & group : groups )
+  {
+    if( group.empty() )
+    { continue; }
+    bool withglobals = any_of(group.begin(), group.end(), []( const Function * f ) { return f->getName() == "main"; });
+    parts.push_back(writebitcode(*extract(module, group, withglobals)));
+    names.push_back("part" + to_string(names.size()) + ".o");
+  }
+
+  vector< unique_ptr< MemoryBuffer > > objects;
+  if( !compileparallel(parts, target, jobs, objects) )
+  { return false; }
+  return writearchive(path, objects, names, Triple(target.triple));
+}
@@ -0,0 +1,59 @@
+#ifndef PJPPROJECT_SPLIT_HPP
+#define PJPPROJECT_SPLIT_HPP
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Target/TargetMachine.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Optimizer.hpp"
+
+using namespace llvm;
+using namespace std;
+
+// " MODULE SPLITTING " parts of the program compiled to objects of their own ( --jobs, --incremental )
+
+// What the parts are compiled for, every thread makes its own TargetMachine out of it
+struct targetspec
+{
+  string triple;
+  string cpu;
+  string features;
+  optlevel level;
+};
+
+// a part takes consecutive functions until it has this many instructions, enough that the setup of every
+// object doesn't dominate and few enough that a large program keeps many threads busy
+const size_t partinstructions = 2000;
+
+// Module with the definitions of ( functions ) that only declares what they refer to, the global variables are
+// defined in it if ( withglobals ) and declared otherwise. CloneModule would declare every function of the
+// program in every part, which makes splitting a large program quadratic
+unique_ptr< Module > extract( const Module & module, ArrayRef< const Function * > functions, bool withglobals );
+
+// Bitcode of ( part ), parts move to the LLVMContext of another thread as bitcode
+string writebitcode( const Module & part );
+
+// TargetMachine for ( target ), nullptr with the reason in ( error ) if the target isn't known
+unique_ptr< TargetMachine > createmachine( const targetspec & target, string & error );
+// Compiles ( part ) as it is to an object with ( machine ), nullptr if the target can't emit objects
+unique_ptr< MemoryBuffer > emitobject( Module & part, TargetMachine & machine );
+
+// Compiles the bitcode modules ( parts ) to objects on ( jobs ) threads, 0 uses every core. Each part is read into
+// an LLVMContext of its own and optimized there, the objects come back in the order of the parts
+bool compileparallel( const vector< string > & parts, const targetspec & target, unsigned jobs,
+                      vector< unique_ptr< MemoryBuffer > > & objects );
+
+// Writes ( objects ) to ( path ) as one archive, the member ( i ) is named ( names[i] )
+bool writearchive( const string & path, const vector< unique_ptr< MemoryBuffer > > & objects,
+                   const vector< string > & names, const Triple & triple );
+
+// Writes ( module ) to ( path ) as an archive of objects of consecutive functions compiled on ( jobs ) threads.
+// The split only depends on the module, any number of threads makes the same archive
+bool emitsplit( const Module & module, const targetspec & target, unsigned jobs, const string & path );
+
+#endif //PJPPROJECT_SPLIT_HPP
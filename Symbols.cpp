@@ -0,0 +1,187 @@
+#include "Symbols.hpp"
+#include "Parser.hpp"
+
+// " SYMBOL TABLE "
+symboltable symbols;
+
+void symboltable::pop()
+{
+  // restore what the bindings of the scope shadowed, newest first
+  size_t mark = scopes.back();
+  scopes.pop_back();
+  while( bindings.size() > mark )
+  {
+    innermost[bindings.back().first] = bindings.back().second;
+    bindings.pop_back();
+  }
+}
+
+symbolid symboltable::declare( uint32_t ident, symbolkind kind, Value * storage )
+{
+  if( ident >= innermost.size() )
+  { innermost.resize(max((size_t) ident + 1, identifiers.size()), nosymbol); }
+
+  symbolid slot = symbols.size();
+  symbols.push_back({ kind, false, ident, storage });
+  // bindings made outside of every scope are never undone
+  if( !scopes.empty() )
+  { bindings.emplace_back(ident, innermost[ident]); }
+  innermost[ident] = slot;
+  return slot;
+}
+
+// Error logging
+static bool LogErrorR( const char * message )
+{
+  LogError(message);
+  return false;
+}
+
+// Returns the slot of the user operator function ( prefix op ) or nosymbol
+static symbolid lookupoperator( const char * prefix, int op )
+{
+  string name = string(prefix) + (char) op;
+  symbolid slot = symbols.lookup(identifiers.find(name));
+  if( slot == nosymbol || symbols[slot].kind != symbolkind::function )
+  { return nosymbol; }
+  return slot;
+}
+
+// Binds the variable node ( n ), only variables and constants are accepted
+static bool resolvevariable( astbody & ast, nodeid n )
+{
+  symbolid slot = symbols.lookup(ast[n].a);
+  if( slot == nosymbol || symbols[slot].kind == symbolkind::function )
+  { return LogErrorR("UNDECLARED VARIABLE NAME"); }
+  ast.slots[n] = slot;
+  return true;
+}
+
+static bool resolvenode( astbody & ast, nodeid n );
+
+static bool resolvelist( astbody & ast, uint32_t list )
+{
+  for( nodeid n : ast.list(list) )
+  {
+    if( !resolvenode(ast, n) )
+    { return false; }
+  }
+  return true;
+}
+
+static bool resolvenode( astbody & ast, nodeid n )
+{
+  const astnode & node = ast[n];
+  switch( node.kind )
+  {
+    case nodekind::number:
+      return true;
+
+    case nodekind::variable:
+      return resolvevariable(ast, n);
+
+    case nodekind::binary:
+      if( node.op == '=' )
+      {
+        if( ast[node.a].kind != nodekind::variable )
+        { return LogErrorR("EQUAL OPERATOR MUST BE ASSIGNED TO A VARIABLE"); }
+        if( !resolvenode(ast, node.b) || !resolvevariable(ast, node.a) )
+        { return false; }
+        if( symbols[ast.slots[node.a]].kind == symbolkind::constant )
+        { return LogErrorR("CONSTANTS CAN'T BE ASSIGNED TO"); }
+        return true;
+      }
+      if( !resolvenode(ast, node.a) || !resolvenode(ast, node.b) )
+      { return false; }
+      if( operatorof(node.op).precedence == 0 )
+      {
+        ast.slots[n] = lookupoperator("binary", node.op);
+        if( ast.slots[n] == nosymbol )
+        { return LogErrorR("UNKNOWN BINARY OPERATOR"); }
+      }
+      return true;
+
+    case nodekind::unary:
+      if( !resolvenode(ast, node.a) )
+      { return false; }
+      if( operatorof(node.op).prefix )
+      { return true; }
+      ast.slots[n] = lookupoperator("unary", node.op);
+      if( ast.slots[n] == nosymbol )
+      { return LogErrorR("UNKNOWN UNARY OPERATOR"); }
+      return true;
+
+    case nodekind::call:
+    {
+      symbolid slot = symbols.lookup(node.a);
+      if( slot == nosymbol || symbols[slot].kind != symbolkind::function )
+      { return LogErrorR("UNDECLARED FUNCTION REFRENCE"); }
+      ast.slots[n] = slot;
+
+      // Argument mismatch error
+      nodelist arguments = ast.list(node.b);
+      if( cast<Function>(symbols[slot].storage)->arg_size() != arguments.size() )
+      { return LogErrorR("INVALID NO. OF ARGUMENTS PASSED"); }
+
+      bool byreference = symbols[slot].byreference;
+      for( nodeid a : arguments )
+      {
+        if( byreference && ast[a].kind != nodekind::variable )
+        { return LogErrorR("EXPECTED A VARIABLE TO READ INTO"); }
+        if( !resolvenode(ast, a) )
+        { return false; }
+      }
+      return true;
+    }
+
+    case nodekind::ifthen:
+      if( !resolvenode(ast, node.a) || !resolvelist(ast, node.b) )
+      { return false; }
+      return node.c == nonode || resolvenode(ast, node.c);
+
+    case nodekind::forloop:
+    {
+      // the start is evaluated before the loop variable exists, the end on every iteration
+      if( !resolvenode(ast, node.b) )
+      { return false; }
+      symbols.push();
+      ast.slots[n] = symbols.declare(node.a, symbolkind::local);
+      bool resolved = resolvelist(ast, node.d) && resolvenode(ast, node.c);
+      symbols.pop();
+      return resolved;
+    }
+
+    case nodekind::vars:
+    case nodekind::consts:
+    {
+      // ( name, initializer ) pairs, the names get consecutive slots starting at the node's one
+      nodelist variables = ast.list(node.a);
+      for( size_t i = 1; i < variables.size(); i += 2 )
+      {
+        if( variables[i] != nonode && !resolvenode(ast, variables[i]) )
+        { return false; }
+      }
+      symbolkind kind = node.kind == nodekind::consts ? symbolkind::constant : symbolkind::local;
+      for( size_t i = 0; i < variables.size(); i += 2 )
+      {
+        symbolid slot = symbols.declare(variables[i], kind);
+        if( i == 0 )
+        { ast.slots[n] = slot; }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool resolvestatements( astbody & ast, uint32_t list )
+{
+  ast.slots.resize(ast.nodes.size(), nosymbol);
+  return resolvelist(ast, list);
+}
+
+bool resolveexpression( astbody & ast, nodeid n )
+{
+  ast.slots.resize(ast.nodes.size(), nosymbol);
+  return resolvenode(ast, n);
+}
@@ -0,0 +1,80 @@
+#ifndef PJPPROJECT_SYMBOLS_HPP
+#define PJPPROJECT_SYMBOLS_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ast.hpp"
+
+using namespace llvm;
+using namespace std;
+
+// " SYMBOL SLOT " index of a symbol in the ( symboltable )
+typedef uint32_t symbolid;
+// an identifier that isn't declared in any open scope
+const symbolid nosymbol = UINT32_MAX;
+
+enum class symbolkind : uint8_t
+{
+  // variable of a function, ( storage ) is its alloca
+  local,
+  // ( storage ) is the global variable
+  global,
+  // global constant, can't be assigned to
+  constant,
+  // ( storage ) is the LLVM function
+  function
+};
+
+struct symbol
+{
+  symbolkind kind;
+  // the function gets the addresses of its arguments instead of their values ( readln )
+  bool byreference;
+  // interned identifier id of the name
+  uint32_t ident;
+  // set by codegen for locals, right away for everything else
+  Value * storage;
+};
+
+// " SYMBOL TABLE " every declared symbol gets a slot, names are bound to slots per scope.
+// ( innermost ) maps an identifier id straight to its visible symbol, each binding remembers the
+// one it shadows so pushing a scope is O(1) and popping it only undoes the bindings made inside
+class symboltable
+{
+private:
+  vector< symbol > symbols;
+  // identifier id -> innermost visible slot or nosymbol
+  vector< symbolid > innermost;
+  // ( identifier id, shadowed slot ) of every binding in the open scopes
+  vector< pair< uint32_t, symbolid > > bindings;
+  // size of ( bindings ) when each open scope was pushed
+  vector< size_t > scopes;
+
+public:
+  void push()
+  { scopes.push_back(bindings.size()); }
+  void pop();
+
+  // Declares ( ident ) in the innermost scope and returns its new slot
+  symbolid declare( uint32_t ident, symbolkind kind, Value * storage = nullptr );
+  // Returns the slot ( ident ) refers to in the open scopes
+  symbolid lookup( int ident ) const
+  { return ident >= 0 && (size_t) ident < innermost.size() ? innermost[ident] : nosymbol; }
+
+  symbol & operator[]( symbolid slot ) { return symbols[slot]; }
+  size_t size() const { return symbols.size(); }
+  // Drops the slots from ( count ) on, once the scopes that declared them are popped
+  void truncate( size_t count ) { symbols.resize(count); }
+};
+
+extern symboltable symbols;
+
+// " NAME RESOLUTION " binds every variable, call and user operator of ( ast ) to its symbol slot in
+// ( ast.slots ) and checks assignments and argument counts, codegen only follows the slots.
+// Declarations are added to the innermost scope of ( symbols ), for loops get scopes of their own
+bool resolvestatements( astbody & ast, uint32_t list );
+bool resolveexpression( astbody & ast, nodeid n );
+
+#endif //PJPPROJECT_SYMBOLS_HPP
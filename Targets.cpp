@@ -0,0 +1,56 @@
+#include "Targets.hpp"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+
+using namespace llvm;
+
+#ifdef MILA_ALL_TARGETS
+// Sets up the backend ( name ) of a target looked up by its triple, "X86", "AArch64", "RISCV", ...
+static void initializebackend( StringRef name )
+{
+#define LLVM_TARGET( backend ) \
+  if( name == #backend ) \
+  { \
+    LLVMInitialize##backend##Target(); \
+    LLVMInitialize##backend##TargetMC(); \
+  }
+#include "llvm/Config/Targets.def"
+#define LLVM_ASM_PRINTER( backend ) \
+  if( name == #backend ) \
+  { LLVMInitialize##backend##AsmPrinter(); }
+#include "llvm/Config/AsmPrinters.def"
+#define LLVM_ASM_PARSER( backend ) \
+  if( name == #backend ) \
+  { LLVMInitialize##backend##AsmParser(); }
+#include "llvm/Config/AsmParsers.def"
+}
+#endif
+
+bool initializetarget( const string & triple, string & error )
+{
+  // the native backend also compiles for the other triples of its architecture, i686 on x86_64
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+  InitializeNativeTargetAsmParser();
+  if( TargetRegistry::lookupTarget(triple, error) )
+  { return true; }
+#ifdef MILA_ALL_TARGETS
+  // the names of all the targets are cheap to register, only the one found gets its backend
+  InitializeAllTargetInfos();
+  const Target * found = TargetRegistry::lookupTarget(triple, error);
+  if( !found )
+  { return false; }
+  initializebackend(found->getBackendName());
+  if( !found->hasTargetMachine() )
+  {
+    error = "mila has no backend for the target: " + triple;
+    return false;
+  }
+  return true;
+#else
+  error += ", mila was built only for the native target ( MILA_TARGETS=native )";
+  return false;
+#endif
+}
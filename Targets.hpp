@@ -0,0 +1,15 @@
+#ifndef PJPPROJECT_TARGETS_HPP
+#define PJPPROJECT_TARGETS_HPP
+
+#include <string>
+
+using namespace std;
+
+// " TARGETS " only the backend the output is for gets set up. The native one is enough without --target, the
+// others are looked up when --target names a triple the native backend can't compile for. mila links every backend
+// only if it was configured with MILA_TARGETS=all-targets, otherwise it only has the native one
+
+// Sets up the backend compiling for ( triple ), false with the reason in ( error ) if mila wasn't built with it
+bool initializetarget( const string & triple, string & error );
+
+#endif //PJPPROJECT_TARGETS_HPP
@@ -0,0 +1,603 @@
+#include "Tiered.hpp"
+#include "Jit.hpp"
+#include "Optimizer.hpp"
+#include "Parser.hpp"
+#include "Symbols.hpp"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+using namespace llvm::orc;
+using namespace std::chrono;
+
+namespace
+{
+
+// native code is called through a pointer of its own type, functions with more arguments stay interpreted
+const size_t maxnativearguments = 6;
+
+// ( functionof ) of the builtins and of the functions that were declared but never defined
+const int32_t builtinwriteln = -1;
+const int32_t builtinreadln = -2;
+const int32_t undefinedfunction = -3;
+
+// " TIER STATE " of one defined function
+struct tierfunction
+{
+  const funct * definition = nullptr;
+  Function * function = nullptr;
+  // calls and loop backedges so far
+  uint32_t heat = 0;
+  bool requested = false;
+  // written by the compiler thread once the native code is ready, the interpreter only reads it
+  atomic< void * > native { nullptr };
+};
+
+// frame of the call an expression is evaluated in
+struct activation
+{
+  // position of the frame in ( tieredengine::stack )
+  size_t frame;
+  // symbol slot of the frame's first entry, lower slots are globals
+  uint32_t base;
+  // function that gets the backedges, nullptr in main
+  tierfunction * owner;
+};
+
+template< typename R, typename ... A >
+int32_t invoke( void * code, A ... arguments )
+{
+  if constexpr( is_void_v< R > )
+  {
+    ((R (*)( A ... )) code)(arguments ...);
+    return 0;
+  }
+  else
+  { return ((R (*)( A ... )) code)(arguments ...); }
+}
+
+// Calls native code taking ( count ) arguments, procedures give 0
+int32_t callnative( void * code, bool procedure, const int32_t * a, size_t count )
+{
+  switch( count )
+  {
+    case 0:
+      return procedure ? invoke< void >(code) : invoke< int32_t >(code);
+    case 1:
+      return procedure ? invoke< void >(code, a[0]) : invoke< int32_t >(code, a[0]);
+    case 2:
+      return procedure ? invoke< void >(code, a[0], a[1]) : invoke< int32_t >(code, a[0], a[1]);
+    case 3:
+      return procedure ? invoke< void >(code, a[0], a[1], a[2]) : invoke< int32_t >(code, a[0], a[1], a[2]);
+    case 4:
+      return procedure ? invoke< void >(code, a[0], a[1], a[2], a[3])
+                       : invoke< int32_t >(code, a[0], a[1], a[2], a[3]);
+    case 5:
+      return procedure ? invoke< void >(code, a[0], a[1], a[2], a[3], a[4])
+                       : invoke< int32_t >(code, a[0], a[1], a[2], a[3], a[4]);
+    default:
+      return procedure ? invoke< void >(code, a[0], a[1], a[2], a[3], a[4], a[5])
+                       : invoke< int32_t >(code, a[0], a[1], a[2], a[3], a[4], a[5]);
+  }
+}
+
+// the functions the runtime provides to the compiled code
+bool isruntime( StringRef name )
+{ return name == "writeln" || name == "write" || name == "readln"; }
+
+// 32 bit arithmetic wrapping around like the generated code does
+int32_t wrap( uint32_t value )
+{ return (int32_t) value; }
+
+class tieredengine
+{
+private:
+  uint32_t threshold;
+  bool stats;
+
+  // " TIER 0 " state, only the interpreting thread touches it
+  // value of every global and constant by symbol slot, the compiled code works on the same memory
+  vector< int32_t > cells;
+  // symbol slot of a function -> index into ( functions ) or one of the builtin values
+  vector< int32_t > functionof;
+  vector< tierfunction > functions;
+  // frames of the running calls, the arguments followed by the locals
+  vector< int32_t > stack;
+
+  // " COMPILER THREAD " state, ( indexof ) is only read once the thread runs
+  DenseMap< const Function *, uint32_t > indexof;
+  std::thread compiler;
+  mutex queuelock;
+  condition_variable queued;
+  deque< uint32_t > queue;
+  bool stopping;
+  // owns the context of ( module ), every part of it compiled shares it
+  ThreadSafeContext tscontext;
+  unique_ptr< TargetMachine > machine;
+  unique_ptr< LLJIT > jit;
+  SmallPtrSet< const Function *, 32 > compiled;
+  // set when the JIT fails, the program keeps running interpreted
+  atomic< bool > jitfailed;
+  unsigned compiles;
+  duration< double > compiletime;
+
+  int32_t & variable( const astbody & ast, nodeid n, const activation & at );
+  int32_t evaluate( const astbody & ast, nodeid n, const activation & at );
+  int32_t call( int32_t index, size_t frame );
+
+  void request( uint32_t index );
+  void compilerloop();
+  bool createjit();
+  void compile( uint32_t index );
+
+public:
+  tieredengine( const vector< unique_ptr< funct > > & program, uint32_t t, bool s );
+
+  void run( const vector< unique_ptr< funct > > & program );
+  void finish();
+};
+
+tieredengine::tieredengine( const vector< unique_ptr< funct > > & program, uint32_t t, bool s ) :
+threshold(max(t, 1u)), stats(s), stopping(false), tscontext(move(context)), jitfailed(false), compiles(0),
+compiletime(0)
+{
+  size_t count = 0;
+  for( auto & def : program )
+  {
+    if( def->getproto().getname() != "main" )
+    { count++; }
+  }
+
+  functions = vector< tierfunction >(count);
+  uint32_t index = 0;
+  for( auto & def : program )
+  {
+    if( def->getproto().getname() == "main" )
+    { continue; }
+    functions[index].definition = def.get();
+    functions[index].function = module->getFunction(def->getproto().getname());
+    indexof[functions[index].function] = index;
+    index++;
+  }
+
+  // every slot left after parsing is a global, a constant or a function
+  cells.assign(symbols.size(), 0);
+  functionof.assign(symbols.size(), undefinedfunction);
+  for( symbolid slot = 0; slot < symbols.size(); slot++ )
+  {
+    const symbol & sym = symbols[slot];
+    if( sym.kind == symbolkind::global || sym.kind == symbolkind::constant )
+    {
+      auto * gvar = dyn_cast_or_null< GlobalVariable >(sym.storage);
+      if( gvar && gvar->hasInitializer() )
+      {
+        if( auto * init = dyn_cast< ConstantInt >(gvar->getInitializer()) )
+        { cells[slot] = init->getSExtValue(); }
+      }
+    }
+    else if( sym.kind == symbolkind::function )
+    {
+      auto * func = cast< Function >(sym.storage);
+      if( func->getName() == "writeln" )
+      { functionof[slot] = builtinwriteln; }
+      else if( func->getName() == "readln" )
+      { functionof[slot] = builtinreadln; }
+      else
+      {
+        auto found = indexof.find(func);
+        if( found != indexof.end() )
+        { functionof[slot] = found->second; }
+      }
+    }
+  }
+}
+
+int32_t & tieredengine::variable( const astbody & ast, nodeid n, const activation & at )
+{
+  uint32_t slot = ast.slots[n];
+  return slot >= at.base ? stack[at.frame + slot - at.base] : cells[slot];
+}
+
+// " INTERPRETER " mirrors what codegen generates for every kind of node
+int32_t tieredengine::evaluate( const astbody & ast, nodeid n, const activation & at )
+{
+  const astnode & node = ast[n];
+  switch( node.kind )
+  {
+    case nodekind::number:
+      return (int32_t) node.a;
+
+    case nodekind::variable:
+      return variable(ast, n, at);
+
+    case nodekind::binary:
+    {
+      if( node.op == '=' )
+      {
+        int32_t value = evaluate(ast, node.b, at);
+        variable(ast, node.a, at) = value;
+        return value;
+      }
+
+      int32_t l = evaluate(ast, node.a, at);
+      int32_t r = evaluate(ast, node.b, at);
+      switch( node.op )
+      {
+        case '+':
+          return wrap((uint32_t) l + (uint32_t) r);
+        case '-':
+          return wrap((uint32_t) l - (uint32_t) r);
+        case '*':
+          return wrap((uint32_t) l * (uint32_t) r);
+        case '/':
+        case tok_div:
+          return l / r;
+        case tok_mod:
+          return l % r;
+        case '<':
+          return l < r ? -1 : 0;
+        case tok_lessequal:
+          return l <= r ? -1 : 0;
+        case '>':
+          return l > r ? -1 : 0;
+        case tok_greaterequal:
+          return l >= r ? -1 : 0;
+        case tok_eq:
+          return l == r ? -1 : 0;
+        case tok_notequal:
+          return l != r ? -1 : 0;
+        case tok_and:
+          return l & r;
+        case tok_or:
+          return l | r;
+        case tok_xor:
+          return l ^ r;
+        default:
+          break;
+      }
+
+      // user ( binary ) operator function
+      size_t frame = stack.size();
+      stack.push_back(l);
+      stack.push_back(r);
+      return call(functionof[ast.slots[n]], frame);
+    }
+
+    case nodekind::unary:
+    {
+      int32_t operand = evaluate(ast, node.a, at);
+      if( node.op == '-' )
+      { return wrap(0u - (uint32_t) operand); }
+      if( node.op == tok_not )
+      { return operand == 0 ? -1 : 0; }
+
+      // user ( unary ) operator function
+      size_t frame = stack.size();
+      stack.push_back(operand);
+      return call(functionof[ast.slots[n]], frame);
+    }
+
+    case nodekind::call:
+    {
+      int32_t target = functionof[ast.slots[n]];
+      nodelist arguments = ast.list(node.b);
+      if( target == builtinreadln )
+      {
+        for( nodeid a : arguments )
+        { scanf("%d", &variable(ast, a, at)); }
+        return 0;
+      }
+
+      // the arguments are pushed where the frame of the callee starts
+      size_t frame = stack.size();
+      for( nodeid a : arguments )
+      {
+        int32_t value = evaluate(ast, a, at);
+        stack.push_back(value);
+      }
+      if( target == builtinwriteln )
+      {
+        printf("%d\n", stack[frame]);
+        stack.resize(frame);
+        return 0;
+      }
+      return call(target, frame);
+    }
+
+    case nodekind::ifthen:
+    {
+      if( evaluate(ast, node.a, at) != 0 )
+      {
+        int32_t value = 0;
+        for( nodeid th : ast.list(node.b) )
+        { value = evaluate(ast, th, at); }
+        return value;
+      }
+      return node.c == nonode ? 0 : evaluate(ast, node.c, at);
+    }
+
+    case nodekind::forloop:
+    {
+      // the body runs before the test like in the generated code, the loop stops once the
+      // variable was equal to the end
+      int32_t start = evaluate(ast, node.b, at);
+      variable(ast, n, at) = start;
+      nodelist statements = ast.list(node.d);
+      while( true )
+      {
+        for( nodeid s : statements )
+        { evaluate(ast, s, at); }
+        int32_t end = evaluate(ast, node.c, at);
+        int32_t & counter = variable(ast, n, at);
+        int32_t current = counter;
+        counter = wrap(node.op ? (uint32_t) current + 1 : (uint32_t) current - 1);
+        if( end == current )
+        { break; }
+        if( at.owner && ++at.owner->heat == threshold )
+        { request(at.owner - functions.data()); }
+      }
+      return 0;
+    }
+
+    case nodekind::vars:
+    case nodekind::consts:
+    {
+      // the names of the ( name, initializer ) pairs have consecutive slots
+      nodelist variables = ast.list(node.a);
+      uint32_t slot = ast.slots[n];
+      for( size_t i = 0; i < variables.size(); i += 2, slot++ )
+      {
+        int32_t value = variables[i + 1] == nonode ? 0 : evaluate(ast, variables[i + 1], at);
+        stack[at.frame + slot - at.base] = value;
+      }
+      return 0;
+    }
+  }
+  return 0;
+}
+
+// Calls the function ( index ) with the arguments on the top of the stack from ( frame ) on, pops them
+int32_t tieredengine::call( int32_t index, size_t frame )
+{
+  if( index == undefinedfunction )
+  {
+    fprintf(stderr, "CALL OF A FUNCTION THAT WAS NEVER DEFINED\n");
+    exit(1);
+  }
+
+  tierfunction & f = functions[index];
+  const funct & def = *f.definition;
+  int32_t result = 0;
+  if( void * code = f.native.load(memory_order_acquire) )
+  { result = callnative(code, def.isprocedure, stack.data() + frame, stack.size() - frame); }
+  else
+  {
+    if( ++f.heat == threshold )
+    { request(index); }
+
+    stack.resize(frame + def.framesize, 0);
+    activation at { frame, def.framebase, &f };
+    const astbody & ast = def.getast();
+    for( nodeid s : ast.list(def.getbody()) )
+    { result = evaluate(ast, s, at); }
+    if( def.isprocedure )
+    { result = 0; }
+  }
+  stack.resize(frame);
+  return result;
+}
+
+void tieredengine::run( const vector< unique_ptr< funct > > & program )
+{
+  // main is made of the top level statements, each one was generated on its own
+  for( auto & def : program )
+  {
+    if( def->getproto().getname() != "main" )
+    { continue; }
+    stack.assign(def->framesize, 0);
+    activation at { 0, def->framebase, nullptr };
+    const astbody & ast = def->getast();
+    for( nodeid s : ast.list(def->getbody()) )
+    { evaluate(ast, s, at); }
+  }
+  fflush(stdout);
+}
+
+// " PROMOTION " queues a hot function for the compiler thread, started with the first one
+void tieredengine::request( uint32_t index )
+{
+  tierfunction & f = functions[index];
+  if( f.requested || jitfailed || f.definition->getproto().getarguments().size() > maxnativearguments )
+  { return; }
+  f.requested = true;
+
+  if( !compiler.joinable() )
+  { compiler = std::thread(&tieredengine::compilerloop, this); }
+  {
+    lock_guard< mutex > lock(queuelock);
+    queue.push_back(index);
+  }
+  queued.notify_one();
+}
+
+void tieredengine::compilerloop()
+{
+  while( true )
+  {
+    uint32_t index;
+    {
+      unique_lock< mutex > lock(queuelock);
+      queued.wait(lock, [this] { return stopping || !queue.empty(); });
+      if( stopping )
+      { return; }
+      index = queue.front();
+      queue.pop_front();
+    }
+    compile(index);
+  }
+}
+
+bool LogErrorT( const char * message, Error error )
+{
+  errs() << "tiered: " << message << ": " << toString(move(error)) << ", the program stays interpreted\n";
+  return false;
+}
+
+// Creates the JIT for the host on the compiler thread and binds the runtime and the globals
+bool tieredengine::createjit()
+{
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+
+  auto host = JITTargetMachineBuilder::detectHost();
+  if( !host )
+  { return LogErrorT("could not detect the host", host.takeError()); }
+  auto hostmachine = host->createTargetMachine();
+  if( !hostmachine )
+  { return LogErrorT("could not create the target machine", hostmachine.takeError()); }
+  machine = move(*hostmachine);
+
+  auto created = LLJITBuilder().setJITTargetMachineBuilder(move(*host)).create();
+  if( !created )
+  { return LogErrorT("could not create the JIT", created.takeError()); }
+  jit = move(*created);
+
+  if( Error error = defineruntime(*jit) )
+  { return LogErrorT("could not bind the runtime", move(error)); }
+
+  SymbolMap globals;
+  StringSet<> names;
+  for( symbolid slot = 0; slot < symbols.size(); slot++ )
+  {
+    const symbol & sym = symbols[slot];
+    if( (sym.kind != symbolkind::global && sym.kind != symbolkind::constant) || !sym.storage )
+    { continue; }
+    if( !names.insert(sym.storage->getName()).second )
+    { continue; }
+    globals[jit->mangleAndIntern(sym.storage->getName())] =
+      JITEvaluatedSymbol(pointerToJITTargetAddress(&cells[slot]), JITSymbolFlags::Exported);
+  }
+  if( Error error = jit->getMainJITDylib().define(absoluteSymbols(move(globals))) )
+  { return LogErrorT("could not bind the globals", move(error)); }
+  return true;
+}
+
+// Compiles the function ( index ) with every function it reaches that isn't native yet and swaps
+// their dispatch pointers, the interpreter doesn't touch the module or its context meanwhile
+void tieredengine::compile( uint32_t index )
+{
+  auto start = steady_clock::now();
+  if( jitfailed || (!jit && !createjit()) )
+  {
+    jitfailed = true;
+    return;
+  }
+
+  const Function * root = functions[index].function;
+  SmallPtrSet< const Function *, 16 > closure;
+  SmallVector< const Function *, 16 > work { root };
+  while( !work.empty() )
+  {
+    const Function * func = work.pop_back_val();
+    if( compiled.count(func) || closure.count(func) || isruntime(func->getName()) )
+    { continue; }
+    // a function that was never defined can't be linked, its callers stay interpreted
+    if( func->isDeclaration() )
+    { return; }
+    closure.insert(func);
+    for( const BasicBlock & block : *func )
+    {
+      for( const Instruction & inst : block )
+      {
+        if( auto * callinst = dyn_cast< CallInst >(&inst) )
+        {
+          if( const Function * callee = callinst->getCalledFunction() )
+          { work.push_back(callee); }
+        }
+      }
+    }
+  }
+  if( closure.empty() )
+  { return; }
+
+  // everything else, the globals included, is only declared and resolved by the JIT
+  ValueToValueMapTy map;
+  unique_ptr< Module > part = CloneModule(*module, map, [&closure]( const GlobalValue * value ) {
+    auto * func = dyn_cast< Function >(value);
+    return func && closure.count(func);
+  });
+  part->setDataLayout(jit->getDataLayout());
+  part->setTargetTriple(machine->getTargetTriple().str());
+  optimizemodule(*part, machine.get(), optlevel::O2);
+
+  if( Error error = jit->addIRModule(ThreadSafeModule(move(part), tscontext)) )
+  {
+    jitfailed = !LogErrorT("could not add the module", move(error));
+    return;
+  }
+
+  for( const Function * func : closure )
+  {
+    auto symbol = jit->lookup(func->getName());
+    if( !symbol )
+    {
+      jitfailed = !LogErrorT("could not compile", symbol.takeError());
+      return;
+    }
+    compiled.insert(func);
+    tierfunction & f = functions[indexof[func]];
+    if( f.definition->getproto().getarguments().size() <= maxnativearguments )
+    { f.native.store((void *) symbol->getAddress(), memory_order_release); }
+  }
+
+  compiles++;
+  compiletime += steady_clock::now() - start;
+  if( stats )
+  {
+    errs() << "tiered: compiled " << root->getName() << " with " << closure.size() - 1 << " callees in "
+           << format("%.1f", duration< double, milli >(steady_clock::now() - start).count()) << " ms\n";
+  }
+}
+
+void tieredengine::finish()
+{
+  {
+    lock_guard< mutex > lock(queuelock);
+    stopping = true;
+  }
+  queued.notify_one();
+  if( compiler.joinable() )
+  { compiler.join(); }
+
+  if( stats )
+  {
+    errs() << "tiered: " << compiled.size() << " of " << functions.size() << " functions native after "
+           << compiles << " compiles, " << format("%.1f", compiletime.count() * 1000) << " ms compiling\n";
+  }
+
+  // the module lives in the context ( tscontext ) owns, it has to go first
+  jit.reset();
+  machine.reset();
+  module.reset();
+}
+
+}
+
+int runtiered( const vector< unique_ptr< funct > > & program, uint32_t threshold, bool stats )
+{
+  tieredengine engine(program, threshold, stats);
+  engine.run(program);
+  engine.finish();
+  return 0;
+}
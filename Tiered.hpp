@@ -0,0 +1,21 @@
+#ifndef PJPPROJECT_TIERED_HPP
+#define PJPPROJECT_TIERED_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ast.hpp"
+
+using namespace std;
+
+// " TIERED EXECUTION " ( --tiered ) runs the program without compiling it to machine code first.
+// Tier 0 interprets the resolved AST of ( program ), the definitions and top level statements in source
+// order. Every call and loop backedge heats the function up, at ( threshold ) a background thread JIT
+// compiles it together with everything it calls at -O2 and swaps its dispatch pointer, later calls run
+// the native code. Globals live in one array both tiers work on.
+// Calls already running in the interpreter finish there ( no on stack replacement ), main is never compiled.
+// Takes over ( module ) and ( context ), returns the exit code of the program
+int runtiered( const vector< unique_ptr< funct > > & program, uint32_t threshold, bool stats );
+
+#endif //PJPPROJECT_TIERED_HPP
@@ -1,521 +1,621 @@
-#include "ast.hpp"
-#include "Parser.hpp"
-
-// LLVM " CONTEXT "
-unique_ptr< LLVMContext > context;
-// LLVM " BUILDER "
-unique_ptr< IRBuilder<> > builder;
-// LLVM " MODULE " - functions & global variables
-unique_ptr< Module > module;
-// " SCOPED " variables values ( Symbol Table )
-map< string, AllocaInst * > namedvalues;
-// " FUNCTIONs " and their blueprints
-map< string, unique_ptr< funcproto > > functions;
-unique_ptr< legacy::FunctionPassManager > fpm;
-ExitOnError exitonerr;
-set<string> constants;
-
-// Error logging
-Value * LogErrorV( const char * message )
-{
-  LogError(message);
-  return nullptr;
-}
-
-Function * getfunction( string name )
-{
-  // check if its already exists in the current LLVM " MODULE "
-  auto * func = module->getFunction(name);
-  if( func )
-  { return func; }
-  // else search for it in the map of function prototypes
-  auto find = functions.find(name);
-  if( find != functions.end() )
-  { return find->second->codegen(); }
-  return nullptr;
-}
-
-// Creates an alloca instruction in the entry block of the function, used for mutable variables
-AllocaInst * createblockalloc( Function * func , StringRef var )
-{
-  IRBuilder<> tmp( &func->getEntryBlock(), func->getEntryBlock().begin() );
-  return tmp.CreateAlloca(Type::getInt32Ty(*context), nullptr, var);
-}
-
-void writelnfunc()
-{
-  vector< Type * > Ints(1, Type::getInt32Ty(*context));
-  FunctionType * functype = FunctionType::get(Type::getInt32Ty(*context), Ints, false);
-  Function * func = Function::Create(functype, Function::ExternalLinkage, "writeln", module.get());
-  for( auto & arg : func->args() )
-  { arg.setName("x"); }
-}
-
-void readlnfunc()
-{
-    vector< Type * > Ints(1, Type::getInt32PtrTy(*context));
-    FunctionType * functype = FunctionType::get(Type::getInt32Ty(*context), Ints, false);
-    Function * func = Function::Create(functype, Function::ExternalLinkage, "readln", module.get());
-    for( auto & arg : func->args() )
-    { arg.setName("x"); }
-}
-
-// " EXPRESSION " BASE CLASS
-bool expression::makeglobal()
-{ return true; }
-const string expression::getname() const
-{ return "ERROR BASE CLASS NAME"; }
-
-// " FUNCTION PROTOTYPE "
-const string & funcproto::getname() const
-{ return name; }
-bool funcproto::isunary() const
-{ return isoperator && arguments.size() == 1; }
-bool funcproto::isbinary() const
-{ return isoperator && arguments.size() == 2; }
-char funcproto::operatorname() const
-{ return name[name.size() - 1]; }
-unsigned funcproto::getprecedence() const
-{ return precedence; }
-// " FUNCTION PROTOTYPE " CODEGEN
-Function * funcproto::codegen()
-{
-  vector<Type*> integers(arguments.size(), Type::getInt32Ty(*context));
-
-  // Function type ( RETURN ) either VOID or INTEGER
-  FunctionType *functype = isprocedure ? functype =
-                           FunctionType::get(Type::getVoidTy(*context), integers, false)
-                           :
-                           FunctionType::get(Type::getInt32Ty(*context), integers, false);
-
-  Function * func = Function::Create(functype, Function::ExternalLinkage, name, module.get());
-
-  // Set the names of all the functions arguments
-  unsigned index = 0;
-  for( auto & a : func->args() )
-  { a.setName(arguments[index++]); }
-
-  return func;
-}
-
-// " FUNCTION " CODEGEN
-Function * funct::codegen()
-{
-  auto & p = *proto;
-  functions[proto->getname()] = move(proto);
-
-  Function * thefunc = getfunction(p.getname());
-  if( !thefunc )
-  { return nullptr; }
-
-  if( p.isbinary() )
-  { BinopPrecedence[p.operatorname()] = p.getprecedence(); }
-
-  // BASIC BLOCK to create an entry point for insertion
-  BasicBlock * bb;
-  if( thefunc->begin() == thefunc->end() )
-  {
-    bb = BasicBlock::Create(*context, "entry", thefunc);
-    builder->SetInsertPoint(bb);
-  }
-  else
-  { builder->SetInsertPoint(&*prev(thefunc->end())); }
-
-  // Allocate and add the functions arguments into the symbol table
-  namedvalues.clear();
-  for( auto & a : thefunc->args() )
-  {
-    AllocaInst *alloc = createblockalloc(thefunc, a.getName());
-    builder->CreateStore(&a, alloc);
-    namedvalues[string(a.getName())] = alloc;
-  }
-
-  for( int i = 0; i < body.size() ; i++ )
-  {
-    if( Value * returnval = body[i]->codegen() )
-    {
-      if( (p.getname() != "main") && (i == body.size() - 1) )
-      {
-        if( isprocedure )
-        { builder->CreateRet(nullptr); }
-        else if( !isprocedure )
-        { builder->CreateRet(returnval); }
-      }
-      // Validate the generated code for consistency
-      verifyFunction(*thefunc);
-    }
-    else
-    {
-      thefunc->eraseFromParent();
-      if( p.isbinary() )
-      { BinopPrecedence.erase(p.operatorname()); }
-      return nullptr;
-    }
-  }
-  return thefunc;
-}
-
-// " NUMBER EXPRESSION " CODEGEN
-Value * numexpr::codegen()
-{ return ConstantInt::get(*context, APInt(32, value, true)); }
-
-// " VARIABLE EXPRESSION "
-const string variableexpr::getname() const
-{ return name; }
-// " VARIABLE EXPRESSION " CODEGEN
-Value * variableexpr::codegen()
-{
-  // Look up the variable name in the symbol table
-  Value * v = namedvalues[name];
-  if( !v )
-  {
-    v = module->getNamedGlobal(name);
-    if( !v )
-    { return LogErrorV("UNDECLARED VARIABLE NAME"); }
-  }
-  return builder->CreateLoad(v, name.c_str());
-}
-
-// " BINARY EXPRESSION " CODEGEN
-Value * binexpr::codegen()
-{
-  // Edge case as the LHS is an identifier
-  if( op == '=' )
-  {
-    variableexpr * lhsvar = static_cast<variableexpr*>( lhs.get() );
-    if( !lhsvar )
-    { return LogErrorV("EQUAL OPERATOR MUST BE ASSIGNED TO A VARIABLE"); }
-
-    Value * val = rhs->codegen();
-    if( !val )
-    { return nullptr; }
-
-    if( constants.find(lhsvar->getname()) != constants.end() )
-    { return LogErrorV("UNDECLARED CONSTANT NAME"); }
-
-    Value * var = namedvalues[lhsvar->getname()];
-    if (!var)
-    {
-      var = module->getNamedGlobal(lhsvar->getname());
-      if( !var )
-      { return LogErrorV("UNDECLARED VARIABLE NAME"); }
-    }
-    builder->CreateStore(val, var);
-    module->print(errs(), nullptr);
-
-    return val;
-  }
-
-
-  Value * l = lhs->codegen();
-  Value * r = rhs->codegen();
-  if( !l || !r )
-  { return nullptr; }
-
-  switch (op)
-  {
-    case '+':
-        return builder->CreateAdd(l, r, "addtmp");
-    case '-':
-        return builder->CreateSub(l, r, "subtmp");
-    case '*':
-        return builder->CreateMul(l, r, "multmp");
-    case '/':
-        return builder->CreateSDiv(l, r, "divtmp");
-    case '<':
-        l = builder->CreateICmpSLT(l, r, "lecmptmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    case tok_lessequal:
-        l = builder->CreateICmpSLE(l, r, "lecmptmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    case '>':
-        l = builder->CreateICmpSGT(l, r, "gecmptmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    case tok_greaterequal:
-        l = builder->CreateICmpSGE(l, r, "gecmptmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    case tok_eq:
-        l = builder->CreateICmpEQ(l, r, "lttmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    case tok_notequal:
-        l = builder->CreateICmpNE(l, r, "lttmp");
-        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
-    default:
-        break;
-  }
-
-  Function * func = getfunction( string("binary") + op );
-  Value * ops[2] = { l, r };
-  return builder->CreateCall(func, ops, "binop");
-}
-
-// " FUNCTION CALL " CODEGEN
-Value * callexpr::codegen()
-{
-  // Look up the function name in the global module table
-  Function * called = getfunction(caller);
-  if( !called )
-  { return LogErrorV("UNDECLARED FUNCTION REFRENCE"); }
-
-  // Argument mismatch error
-  if( called->arg_size() != arguments.size() )
-  { return LogErrorV("INVALID NO. OF ARGUMENTS PASSED"); }
-
-  vector<Value *> argsval;
-  for( unsigned i = 0, e = arguments.size(); i != e; ++i )
-  {
-    if( called->getName() == "readln" )
-    {
-      Value * val = namedvalues[arguments[i]->getname()];
-      if( !val )
-      {
-        val = module->getNamedGlobal(arguments[i]->getname());
-        if( !val )
-        { return LogErrorV("UNDECLARED VARIABLE NAME"); }
-      }
-      builder->CreateLoad(builder->CreateIntToPtr(val, Type::getInt32PtrTy(*context)), "ptr");
-      argsval.push_back(builder->CreateIntToPtr(val, Type::getInt32PtrTy(*context)));
-      }
-      else
-      { argsval.push_back(arguments[i]->codegen()); }
-
-      if( !argsval.back() )
-      { return nullptr; }
-  }
-
-  if( called->getReturnType()->isVoidTy() )
-  { return builder->CreateCall(called, argsval); }
-
-  return builder->CreateCall(called, argsval, "calltmp");
-}
-
-// " IF EXPRESSION " CODEGEN
-Value * ifexpr::codegen()
-{
-  Value *condv = cond->codegen();
-  if( !condv )
-  { return nullptr; }
-
-  // Convert the condition into a bool by comparing it in non equality to 0
-  condv = builder->CreateICmpNE(condv, ConstantInt::get(*context, APInt(32, 0, true)), "ifcond");
-
-  Function *thefunc = builder->GetInsertBlock()->getParent();
-  // Create Basic Blocks for the then and else cases, insert the then block at the end of the function
-  BasicBlock *thenbb = BasicBlock::Create(*context, "then", thefunc);
-  BasicBlock *elsebb;
-  if( iselse )
-  { elsebb = BasicBlock::Create(*context, "else"); }
-  BasicBlock *mergebb = BasicBlock::Create(*context, "ifcont");
-  if( !iselse )
-  { builder->CreateCondBr(condv, thenbb, mergebb); }
-  builder->CreateCondBr(condv, thenbb, elsebb);
-
-  builder->SetInsertPoint(thenbb);
-  Value *thenv;
-  for( const auto & th: then )
-  {
-    thenv = th->codegen();
-    if( !thenv )
-    { return nullptr; }
-  }
-  builder->CreateBr(mergebb);
-  thenbb = builder->GetInsertBlock();
-
-  if( iselse )
-  {
-    thefunc->getBasicBlockList().push_back(elsebb);
-    builder->SetInsertPoint(elsebb);
-  }
-  Value *elsev;
-  if( iselse )
-  {
-    elsev = Else->codegen();
-    if( !elsev )
-    { return nullptr; }
-  }
-
-  if( iselse )
-  { builder->CreateBr(mergebb); }
-  elsebb = builder->GetInsertBlock();
-
-  thefunc->getBasicBlockList().push_back(mergebb);
-  builder->SetInsertPoint(mergebb);
-
-  PHINode *node = builder->CreatePHI(Type::getInt32Ty(*context), 2, "iftmp");
-  node->addIncoming(thenv, thenbb);
-  if (iselse)
-  { node->addIncoming(elsev, elsebb); }
-
-  return node;
-}
-
-// " FOR EXPRESSION " CODEGEN
-Value * forexpr::codegen()
-{
-  Function *thefunc = builder->GetInsertBlock()->getParent();
-  AllocaInst *alloc = createblockalloc(thefunc, name);
-
-  Value *startv = start->codegen();
-  if( !startv )
-  { return nullptr; }
-  builder->CreateStore(startv, alloc);
-
-  BasicBlock *loopbb = BasicBlock::Create(*context, "loop", thefunc);
-  builder->CreateBr(loopbb);
-  builder->SetInsertPoint(loopbb);
-
-  AllocaInst * oldval = namedvalues[name];
-  namedvalues[name] = alloc;
-  for( const auto & b: body )
-  {
-    if( !b->codegen() )
-    { return nullptr; }
-  }
-
-  Value * stepv = nullptr;
-  if( step )
-  {
-    stepv = step->codegen();
-    if( !stepv )
-    { return nullptr; }
-  }
-  else
-  { stepv = ConstantInt::get(*context, APInt(32, 1, true)); }
-
-  Value * endcond = end->codegen();
-  if( !endcond )
-  { return nullptr; }
-
-  Value * currvar = builder->CreateLoad(alloc, name.c_str());
-  Value * nextvar;
-  if( to )
-  { nextvar = builder->CreateAdd(currvar, stepv, "nextvar"); }
-  else
-  { nextvar = builder->CreateSub(currvar, stepv, "nextvar"); }
-
-  builder->CreateStore(nextvar, alloc);
-  endcond = builder->CreateICmpNE(endcond, currvar, "loopcond");
-  BasicBlock * afterbb = BasicBlock::Create(*context, "afterloop", thefunc);
-  builder->CreateCondBr(endcond, loopbb, afterbb);
-  builder->SetInsertPoint(afterbb);
-
-  if( oldval )
-  { namedvalues[name] = oldval; }
-  else
-  { namedvalues.erase(name); }
-
-  return Constant::getNullValue(Type::getInt32Ty(*context));
-}
-
-// " UNARY EXPRESSION " CODEGEN
-Value * unaryexpr::codegen()
-{
-  Value *operandv = operand->codegen();
-  if( !operandv )
-  { return nullptr; }
-
-  Function *func = getfunction(string("unary") + opcode);
-  if( !func )
-  { return LogErrorV("UNKNOWN UNARY OPERATOR"); }
-
-  return builder->CreateCall(func, operandv, "unop");
-}
-
-// " VARIABLES " CODEGEN
-Value * varexpr::codegen()
-{
-  vector<AllocaInst*> oldbindings;
-
-  Function *thefunc = builder->GetInsertBlock()->getParent();
-
-  // Register all the variables and emit their initializer
-  for( unsigned i = 0, e = variables.size(); i != e; ++i )
-  {
-    const string & varname = variables[i].first;
-    expression *init = variables[i].second.get();
-
-    Value *initval;
-    if( init )
-    {
-      initval = init->codegen();
-      if( !initval )
-      { return nullptr; }
-    }
-    else
-    { initval = ConstantInt::get(*context, APInt(32, 0, true)); }
-
-    AllocaInst *alloc = createblockalloc(thefunc, varname);
-    builder->CreateStore(initval, alloc);
-
-    oldbindings.push_back(namedvalues[varname]);
-    namedvalues[varname] = alloc;
-  }
-
-  return thefunc;
-}
-bool varexpr::makeglobal()
-{
-  for( const auto & v : variables )
-  {
-    module->getOrInsertGlobal(v.first, builder->getInt32Ty());
-    GlobalVariable *gvar = module->getNamedGlobal(v.first);
-    gvar->setLinkage(GlobalValue::ExternalLinkage);
-    gvar->setInitializer(ConstantInt::get(*context, APInt(32, 0, true)));
-  }
-  return true;
-}
-
-// " CONSTANTS " CODEGEN
-Value * constantexpr::codegen()
-{
-  vector<AllocaInst*> oldbindings;
-  Function *thefunc = builder->GetInsertBlock()->getParent();
-
-  // Register all the variables and emit their initializer
-  for( unsigned i = 0, e = variables.size(); i != e; ++i )
-  {
-    const string & varname = variables[i].first;
-    expression *init = variables[i].second.get();
-
-    Value *initval;
-    if( init )
-    {
-      initval = init->codegen();
-      if( !initval )
-      { return nullptr; }
-    }
-    else
-    { initval = ConstantInt::get(*context, APInt(32, 0, true)); }
-
-    AllocaInst *alloc = createblockalloc(thefunc, varname);
-    builder->CreateStore(initval, alloc);
-
-    oldbindings.push_back(namedvalues[varname]);
-    namedvalues[varname] = alloc;
-  }
-
-  return thefunc;
-}
-bool constantexpr::makeglobal()
-{
-  int varno = 0;
-  for( const auto & v : variables )
-  {
-    module->getOrInsertGlobal(v.first, builder->getInt32Ty());
-    GlobalVariable *gvar = module->getNamedGlobal(v.first);
-    gvar->setLinkage(GlobalValue::ExternalLinkage);
-
-    expression *init = variables[varno].second.get();
-    if( init )
-    {
-      if( auto initval = init->codegen() )
-      { gvar->setInitializer(dyn_cast<llvm::ConstantInt>(initval)); }
-      else
-      { return false; }
-    }
-
-    varno++;
-  }
-
-  return true;
-}
+#include "ast.hpp"
+#include "Parser.hpp"
+#include "Symbols.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/SHA1.h"
+
+// LLVM " CONTEXT "
+unique_ptr< LLVMContext > context;
+// LLVM " BUILDER "
+unique_ptr< IRBuilder<> > builder;
+// LLVM " MODULE " - functions & global variables
+unique_ptr< Module > module;
+unique_ptr< legacy::FunctionPassManager > fpm;
+ExitOnError exitonerr;
+// " AST STATISTICS "
+aststatistics aststats;
+// " FUNCTION HASHES "
+bool hashfunctions = false;
+map< const Function *, string > functionhashes;
+
+// LLVM name of the identifier ( ident )
+static StringRef identname( uint32_t ident )
+{
+  string_view name = identifiers.name(ident);
+  return StringRef(name.data(), name.size());
+}
+
+// Creates an alloca instruction in the entry block of the function, used for mutable variables
+AllocaInst * createblockalloc( Function * func , StringRef var )
+{
+  IRBuilder<> tmp( &func->getEntryBlock(), func->getEntryBlock().begin() );
+  return tmp.CreateAlloca(Type::getInt32Ty(*context), nullptr, var);
+}
+
+void writelnfunc()
+{
+  vector< Type * > Ints(1, Type::getInt32Ty(*context));
+  FunctionType * functype = FunctionType::get(Type::getInt32Ty(*context), Ints, false);
+  Function * func = Function::Create(functype, Function::ExternalLinkage, "writeln", module.get());
+  for( auto & arg : func->args() )
+  { arg.setName("x"); }
+  symbols.declare(identifiers.intern("writeln"), symbolkind::function, func);
+}
+
+void readlnfunc()
+{
+    vector< Type * > Ints(1, Type::getInt32PtrTy(*context));
+    FunctionType * functype = FunctionType::get(Type::getInt32Ty(*context), Ints, false);
+    Function * func = Function::Create(functype, Function::ExternalLinkage, "readln", module.get());
+    for( auto & arg : func->args() )
+    { arg.setName("x"); }
+    // readln stores into the variables it gets
+    symbolid slot = symbols.declare(identifiers.intern("readln"), symbolkind::function, func);
+    symbols[slot].byreference = true;
+}
+
+// " AST STATISTICS "
+void aststatistics::record( const astbody & ast )
+{
+  items++;
+  nodes += ast.nodes.size();
+  listwords += ast.lists.size();
+  peakbytes = max(peakbytes, ast.nodes.size() * sizeof(astnode) + ast.lists.size() * sizeof(uint32_t));
+}
+void aststatistics::print( FILE * out ) const
+{
+  fprintf(out, "AST: %zu top level items, %zu nodes of %zu bytes, %zu list words, largest tree %zu bytes\n",
+          items, nodes, sizeof(astnode), listwords, peakbytes);
+}
+
+// " FUNCTION PROTOTYPE "
+const string & funcproto::getname() const
+{ return name; }
+const vector< string > & funcproto::getarguments() const
+{ return arguments; }
+bool funcproto::isunary() const
+{ return isoperator && arguments.size() == 1; }
+bool funcproto::isbinary() const
+{ return isoperator && arguments.size() == 2; }
+char funcproto::operatorname() const
+{ return name[name.size() - 1]; }
+unsigned funcproto::getprecedence() const
+{ return precedence; }
+
+// " FUNCTION "
+const funcproto & funct::getproto() const
+{ return *proto; }
+const astbody & funct::getast() const
+{ return ast; }
+uint32_t funct::getbody() const
+{ return body; }
+// " FUNCTION HASH "
+static void hashint( SHA1 & hash, uint32_t value )
+{ hash.update(ArrayRef<uint8_t>((const uint8_t *) &value, sizeof(value))); }
+
+static void hashname( SHA1 & hash, StringRef name )
+{
+  hashint(hash, name.size());
+  hash.update(name);
+}
+
+// Locals by their place in the frame, everything else by its name, functions with their signature
+static void hashsymbol( SHA1 & hash, symbolid slot, uint32_t framebase )
+{
+  if( slot == nosymbol )
+  {
+    hashint(hash, nosymbol);
+    return;
+  }
+  if( slot >= framebase )
+  {
+    hashint(hash, 0);
+    hashint(hash, slot - framebase);
+    return;
+  }
+  const symbol & s = symbols[slot];
+  hashint(hash, 1 + (uint32_t) s.kind);
+  hashname(hash, s.storage->getName());
+  if( auto * f = dyn_cast<Function>(s.storage) )
+  {
+    hashint(hash, f->arg_size());
+    hashint(hash, f->getReturnType()->isVoidTy());
+    hashint(hash, s.byreference);
+  }
+}
+
+static void hashlist( SHA1 & hash, const astbody & ast, uint32_t list )
+{
+  nodelist items = ast.list(list);
+  hashint(hash, items.size());
+  for( nodeid n : items )
+  { hashint(hash, n); }
+}
+
+// The ids of the nodes only depend on the function's own tree, identifier ids depend on the whole
+// program so the names are hashed instead
+string funct::hash() const
+{
+  SHA1 hash;
+  hashname(hash, proto->getname());
+  hashint(hash, proto->getarguments().size());
+  hashint(hash, isprocedure);
+  hashint(hash, proto->getprecedence());
+  hashlist(hash, ast, body);
+  for( nodeid n = 0; n < ast.nodes.size(); n++ )
+  {
+    const astnode & node = ast[n];
+    hashint(hash, (uint32_t) node.kind);
+    hashint(hash, (uint32_t) node.op);
+    switch( node.kind )
+    {
+      case nodekind::number:
+        hashint(hash, node.a);
+        break;
+      case nodekind::variable:
+        hashsymbol(hash, ast.slots[n], framebase);
+        break;
+      case nodekind::binary:
+      case nodekind::unary:
+        hashint(hash, node.a);
+        hashint(hash, node.b);
+        hashsymbol(hash, ast.slots[n], framebase);
+        break;
+      case nodekind::call:
+        hashsymbol(hash, ast.slots[n], framebase);
+        hashlist(hash, ast, node.b);
+        break;
+      case nodekind::ifthen:
+        hashint(hash, node.a);
+        hashlist(hash, ast, node.b);
+        hashint(hash, node.c);
+        break;
+      case nodekind::forloop:
+        hashsymbol(hash, ast.slots[n], framebase);
+        hashint(hash, node.b);
+        hashint(hash, node.c);
+        hashlist(hash, ast, node.d);
+        break;
+      case nodekind::vars:
+      case nodekind::consts:
+      {
+        hashsymbol(hash, ast.slots[n], framebase);
+        nodelist variables = ast.list(node.a);
+        for( size_t i = 0; i < variables.size(); i += 2 )
+        { hashint(hash, variables[i + 1]); }
+        break;
+      }
+    }
+  }
+  return toHex(hash.final(), true);
+}
+
+// " FUNCTION PROTOTYPE " CODEGEN
+Function * funcproto::codegen()
+{
+  vector<Type*> integers(arguments.size(), Type::getInt32Ty(*context));
+
+  // Function type ( RETURN ) either VOID or INTEGER
+  FunctionType *functype = isprocedure ? functype =
+                           FunctionType::get(Type::getVoidTy(*context), integers, false)
+                           :
+                           FunctionType::get(Type::getInt32Ty(*context), integers, false);
+
+  Function * func = Function::Create(functype, Function::ExternalLinkage, name, module.get());
+
+  // Set the names of all the functions arguments
+  unsigned index = 0;
+  for( auto & a : func->args() )
+  { a.setName(arguments[index++]); }
+
+  // calls find it by the identifier, functions the program can't name ( main ) don't need a symbol
+  int ident = identifiers.find(name);
+  if( ident >= 0 )
+  { symbols.declare(ident, symbolkind::function, func); }
+
+  return func;
+}
+
+// " FUNCTION " CODEGEN
+Function * funct::codegen()
+{
+  auto & p = *proto;
+  // a forward declaration or the earlier statements of the main program created it already
+  Function * thefunc = module->getFunction(p.getname());
+  if( !thefunc )
+  { thefunc = p.codegen(); }
+  if( p.isbinary() )
+  { userprecedence[(unsigned char) p.operatorname()] = p.getprecedence(); }
+
+  // The arguments and the locals live in a scope of their own, bind every name before any IR is built
+  size_t outer = symbols.size();
+  symbols.push();
+  vector< symbolid > arguments;
+  for( const auto & a : p.getarguments() )
+  { arguments.push_back(symbols.declare(identifiers.find(a), symbolkind::local)); }
+  bool resolved = resolvestatements(ast, body);
+
+  if( resolved )
+  {
+    // BASIC BLOCK to create an entry point for insertion
+    if( thefunc->begin() == thefunc->end() )
+    { builder->SetInsertPoint(BasicBlock::Create(*context, "entry", thefunc)); }
+    else
+    { builder->SetInsertPoint(&*prev(thefunc->end())); }
+
+    // Allocate the functions arguments
+    unsigned index = 0;
+    for( auto & a : thefunc->args() )
+    {
+      AllocaInst *alloc = createblockalloc(thefunc, a.getName());
+      builder->CreateStore(&a, alloc);
+      symbols[arguments[index++]].storage = alloc;
+    }
+  }
+
+  nodelist statements = ast.list(body);
+  for( size_t i = 0; resolved && i < statements.size(); i++ )
+  {
+    Value * returnval = ::codegen(ast, statements[i]);
+    if( !returnval )
+    {
+      resolved = false;
+      break;
+    }
+    if( (p.getname() != "main") && (i == statements.size() - 1) )
+    {
+      if( isprocedure )
+      { builder->CreateRet(nullptr); }
+      else if( !isprocedure )
+      { builder->CreateRet(returnval); }
+    }
+  }
+
+  // Validate the finished function and clean it up while the rest of the program is being parsed,
+  // main grows with every top level statement so it's left to the pass over the whole module
+  if( resolved && p.getname() != "main" && !verifyFunction(*thefunc, &errs()) && fpm )
+  { fpm->run(*thefunc); }
+
+  // the slots from ( outer ) on are reused by the next function, the interpreter keeps them per call
+  framebase = outer;
+  framesize = symbols.size() - outer;
+  if( hashfunctions )
+  {
+    // a failed statement of main deletes the statements before it too
+    if( !resolved )
+    { functionhashes.erase(thefunc); }
+    else if( p.getname() == "main" )
+    { functionhashes[thefunc] = toHex(SHA1::hash(arrayRefFromStringRef(functionhashes[thefunc] + hash())), true); }
+    else
+    { functionhashes[thefunc] = hash(); }
+  }
+  symbols.pop();
+  symbols.truncate(outer);
+  if( resolved )
+  { return thefunc; }
+
+  // Keep only a declaration so the calls already generated stay valid
+  thefunc->deleteBody();
+  if( p.isbinary() )
+  { userprecedence[(unsigned char) p.operatorname()] = 0; }
+  return nullptr;
+}
+
+// " NUMBER EXPRESSION " CODEGEN
+static Value * numbercodegen( const astnode & node )
+{ return ConstantInt::get(*context, APInt(32, (int) node.a, true)); }
+
+// " VARIABLE EXPRESSION " CODEGEN
+static Value * variablecodegen( const astbody & ast, nodeid n )
+{ return builder->CreateLoad(builder->getInt32Ty(), symbols[ast.slots[n]].storage, identname(ast[n].a)); }
+
+// " BINARY EXPRESSION " CODEGEN
+static Value * binarycodegen( const astbody & ast, nodeid n )
+{
+  const astnode & node = ast[n];
+  char op = node.op;
+  // Edge case as the LHS is an identifier, the resolution checked it isn't a constant
+  if( op == '=' )
+  {
+    Value * val = codegen(ast, node.b);
+    if( !val )
+    { return nullptr; }
+
+    builder->CreateStore(val, symbols[ast.slots[node.a]].storage);
+
+    return val;
+  }
+
+
+  Value * l = codegen(ast, node.a);
+  Value * r = codegen(ast, node.b);
+  if( !l || !r )
+  { return nullptr; }
+
+  switch (op)
+  {
+    case '+':
+        return builder->CreateAdd(l, r, "addtmp");
+    case '-':
+        return builder->CreateSub(l, r, "subtmp");
+    case '*':
+        return builder->CreateMul(l, r, "multmp");
+    case '/':
+        return builder->CreateSDiv(l, r, "divtmp");
+    case '<':
+        l = builder->CreateICmpSLT(l, r, "lecmptmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case tok_lessequal:
+        l = builder->CreateICmpSLE(l, r, "lecmptmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case '>':
+        l = builder->CreateICmpSGT(l, r, "gecmptmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case tok_greaterequal:
+        l = builder->CreateICmpSGE(l, r, "gecmptmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case tok_eq:
+        l = builder->CreateICmpEQ(l, r, "lttmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case tok_notequal:
+        l = builder->CreateICmpNE(l, r, "lttmp");
+        return builder->CreateIntCast(l, Type::getInt32Ty(*context), true, "booltmp");
+    case tok_div:
+        return builder->CreateSDiv(l, r, "divtmp");
+    case tok_mod:
+        return builder->CreateSRem(l, r, "modtmp");
+    case tok_and:
+        return builder->CreateAnd(l, r, "andtmp");
+    case tok_or:
+        return builder->CreateOr(l, r, "ortmp");
+    case tok_xor:
+        return builder->CreateXor(l, r, "xortmp");
+    default:
+        break;
+  }
+
+  // user ( binary ) operator function
+  Value * ops[2] = { l, r };
+  return builder->CreateCall(cast<Function>(symbols[ast.slots[n]].storage), ops, "binop");
+}
+
+// " FUNCTION CALL " CODEGEN
+static Value * callcodegen( const astbody & ast, nodeid n )
+{
+  const symbol & called = symbols[ast.slots[n]];
+  Function * func = cast<Function>(called.storage);
+
+  vector<Value *> argsval;
+  for( nodeid a : ast.list(ast[n].b) )
+  {
+    // readln gets the address of the variable it stores into
+    if( called.byreference )
+    { argsval.push_back(symbols[ast.slots[a]].storage); }
+    else
+    { argsval.push_back(codegen(ast, a)); }
+
+    if( !argsval.back() )
+    { return nullptr; }
+  }
+
+  if( func->getReturnType()->isVoidTy() )
+  { return builder->CreateCall(func, argsval); }
+
+  return builder->CreateCall(func, argsval, "calltmp");
+}
+
+// " IF EXPRESSION " CODEGEN
+static Value * ifcodegen( const astbody & ast, nodeid n )
+{
+  const astnode & node = ast[n];
+  Value *condv = codegen(ast, node.a);
+  if( !condv )
+  { return nullptr; }
+
+  // Convert the condition into a bool by comparing it in non equality to 0
+  condv = builder->CreateICmpNE(condv, ConstantInt::get(*context, APInt(32, 0, true)), "ifcond");
+
+  bool iselse = node.c != nonode;
+  Function *thefunc = builder->GetInsertBlock()->getParent();
+  BasicBlock *condbb = builder->GetInsertBlock();
+  // Create Basic Blocks for the then and else cases, insert the then block at the end of the function
+  BasicBlock *thenbb = BasicBlock::Create(*context, "then", thefunc);
+  BasicBlock *elsebb = iselse ? BasicBlock::Create(*context, "else") : nullptr;
+  BasicBlock *mergebb = BasicBlock::Create(*context, "ifcont");
+  builder->CreateCondBr(condv, thenbb, iselse ? elsebb : mergebb);
+
+  builder->SetInsertPoint(thenbb);
+  Value *thenv = ConstantInt::get(*context, APInt(32, 0, true));
+  for( nodeid th : ast.list(node.b) )
+  {
+    thenv = codegen(ast, th);
+    if( !thenv )
+    { return nullptr; }
+  }
+  builder->CreateBr(mergebb);
+  thenbb = builder->GetInsertBlock();
+
+  // without an else the value is 0 when the condition doesn't hold
+  Value *elsev = ConstantInt::get(*context, APInt(32, 0, true));
+  if( iselse )
+  {
+    thefunc->getBasicBlockList().push_back(elsebb);
+    builder->SetInsertPoint(elsebb);
+    elsev = codegen(ast, node.c);
+    if( !elsev )
+    { return nullptr; }
+    builder->CreateBr(mergebb);
+    elsebb = builder->GetInsertBlock();
+  }
+  else
+  { elsebb = condbb; }
+
+  thefunc->getBasicBlockList().push_back(mergebb);
+  builder->SetInsertPoint(mergebb);
+
+  PHINode *phi = builder->CreatePHI(Type::getInt32Ty(*context), 2, "iftmp");
+  phi->addIncoming(thenv, thenbb);
+  phi->addIncoming(elsev, elsebb);
+
+  return phi;
+}
+
+// " FOR EXPRESSION " CODEGEN
+static Value * forcodegen( const astbody & ast, nodeid n )
+{
+  const astnode & node = ast[n];
+  Function *thefunc = builder->GetInsertBlock()->getParent();
+  AllocaInst *alloc = createblockalloc(thefunc, identname(node.a));
+
+  Value *startv = codegen(ast, node.b);
+  if( !startv )
+  { return nullptr; }
+  builder->CreateStore(startv, alloc);
+
+  BasicBlock *loopbb = BasicBlock::Create(*context, "loop", thefunc);
+  builder->CreateBr(loopbb);
+  builder->SetInsertPoint(loopbb);
+
+  // the loop variable has a slot of its own, nothing it shadows has to be restored afterwards
+  symbols[ast.slots[n]].storage = alloc;
+  for( nodeid b : ast.list(node.d) )
+  {
+    if( !codegen(ast, b) )
+    { return nullptr; }
+  }
+
+  Value * stepv = ConstantInt::get(*context, APInt(32, 1, true));
+
+  Value * endcond = codegen(ast, node.c);
+  if( !endcond )
+  { return nullptr; }
+
+  Value * currvar = builder->CreateLoad(builder->getInt32Ty(), alloc, identname(node.a));
+  Value * nextvar;
+  if( node.op )
+  { nextvar = builder->CreateAdd(currvar, stepv, "nextvar"); }
+  else
+  { nextvar = builder->CreateSub(currvar, stepv, "nextvar"); }
+
+  builder->CreateStore(nextvar, alloc);
+  endcond = builder->CreateICmpNE(endcond, currvar, "loopcond");
+  BasicBlock * afterbb = BasicBlock::Create(*context, "afterloop", thefunc);
+  builder->CreateCondBr(endcond, loopbb, afterbb);
+  builder->SetInsertPoint(afterbb);
+
+  return Constant::getNullValue(Type::getInt32Ty(*context));
+}
+
+// " UNARY EXPRESSION " CODEGEN
+static Value * unarycodegen( const astbody & ast, nodeid n )
+{
+  Value *operandv = codegen(ast, ast[n].a);
+  if( !operandv )
+  { return nullptr; }
+
+  switch( ast[n].op )
+  {
+    case '-':
+      return builder->CreateNeg(operandv, "negtmp");
+    case tok_not:
+      operandv = builder->CreateICmpEQ(operandv, ConstantInt::get(*context, APInt(32, 0, true)), "nottmp");
+      return builder->CreateIntCast(operandv, Type::getInt32Ty(*context), true, "booltmp");
+    default:
+      break;
+  }
+
+  // user ( unary ) operator function
+  return builder->CreateCall(cast<Function>(symbols[ast.slots[n]].storage), operandv, "unop");
+}
+
+// " VARIABLES / CONSTANTS " CODEGEN, both are locals of the function they are declared in
+static Value * declarationcodegen( const astbody & ast, nodeid n )
+{
+  Function *thefunc = builder->GetInsertBlock()->getParent();
+
+  // Emit the initializers, the list holds ( name, initializer ) pairs and the names have consecutive slots
+  nodelist variables = ast.list(ast[n].a);
+  symbolid slot = ast.slots[n];
+  for( size_t i = 0; i < variables.size(); i += 2, slot++ )
+  {
+    nodeid init = variables[i + 1];
+
+    Value *initval;
+    if( init != nonode )
+    {
+      initval = codegen(ast, init);
+      if( !initval )
+      { return nullptr; }
+    }
+    else
+    { initval = ConstantInt::get(*context, APInt(32, 0, true)); }
+
+    AllocaInst *alloc = createblockalloc(thefunc, identname(variables[i]));
+    builder->CreateStore(initval, alloc);
+    symbols[slot].storage = alloc;
+  }
+
+  return thefunc;
+}
+
+// " NODE " CODEGEN
+Value * codegen( const astbody & ast, nodeid n )
+{
+  switch( ast[n].kind )
+  {
+    case nodekind::number:
+      return numbercodegen(ast[n]);
+    case nodekind::variable:
+      return variablecodegen(ast, n);
+    case nodekind::binary:
+      return binarycodegen(ast, n);
+    case nodekind::unary:
+      return unarycodegen(ast, n);
+    case nodekind::call:
+      return callcodegen(ast, n);
+    case nodekind::ifthen:
+      return ifcodegen(ast, n);
+    case nodekind::forloop:
+      return forcodegen(ast, n);
+    case nodekind::vars:
+    case nodekind::consts:
+      return declarationcodegen(ast, n);
+  }
+  return nullptr;
+}
+
+// " GLOBAL VARIABLES / CONSTANTS "
+bool makeglobal( astbody & ast, nodeid n )
+{
+  const astnode & node = ast[n];
+  if( node.kind != nodekind::vars && node.kind != nodekind::consts )
+  { return true; }
+
+  nodelist variables = ast.list(node.a);
+  for( size_t i = 0; i < variables.size(); i += 2 )
+  {
+    StringRef varname = identname(variables[i]);
+    module->getOrInsertGlobal(varname, builder->getInt32Ty());
+    GlobalVariable *gvar = module->getNamedGlobal(varname);
+    gvar->setLinkage(GlobalValue::ExternalLinkage);
+
+    nodeid init = variables[i + 1];
+    if( node.kind == nodekind::vars )
+    { gvar->setInitializer(ConstantInt::get(*context, APInt(32, 0, true))); }
+    else if( init != nonode )
+    {
+      if( !resolveexpression(ast, init) )
+      { return false; }
+      if( auto initval = codegen(ast, init) )
+      { gvar->setInitializer(dyn_cast<llvm::ConstantInt>(initval)); }
+      else
+      { return false; }
+    }
+
+    // globals are declared outside of every scope and stay visible to the rest of the program
+    symbols.declare(variables[i], node.kind == nodekind::consts ? symbolkind::constant : symbolkind::global, gvar);
+  }
+
+  return true;
+}
@@ -1,238 +1,236 @@
-#ifndef PJPPROJECT_AST_HPP
-#define PJPPROJECT_AST_HPP
-
-#include "llvm/Support/TargetSelect.h"
-#include "llvm/Support/Error.h"
-#include "llvm/Target/TargetMachine.h"
-#include "llvm/Transforms/InstCombine/InstCombine.h"
-#include "llvm/Transforms/Scalar.h"
-#include "llvm/Transforms/Scalar/GVN.h"
-#include "llvm/ADT/APFloat.h"
-#include "llvm/ADT/STLExtras.h"
-#include "llvm/ADT/STLExtras.h"
-#include "llvm/IR/Instructions.h"
-#include "llvm/IR/LegacyPassManager.h"
-#include "llvm/IR/LegacyPassManager.h"
-#include "llvm/IR/BasicBlock.h"
-#include "llvm/IR/Constants.h"
-#include "llvm/IR/DerivedTypes.h"
-#include "llvm/IR/Function.h"
-#include "llvm/IR/IRBuilder.h"
-#include "llvm/IR/LLVMContext.h"
-#include "llvm/IR/Module.h"
-#include "llvm/IR/Type.h"
-#include "llvm/IR/Verifier.h"
-
-#include <cstdio>
-#include <cstdlib>
-#include <string>
-#include <vector>
-#include <map>
-#include <memory>
-
-using namespace llvm;
-using namespace std;
-
-
-class funcproto;
-
-// LLVM " CONTEXT "
-extern unique_ptr< LLVMContext > context;
-// LLVM " BUILDER "
-extern unique_ptr< IRBuilder<> > builder;
-// LLVM " MODULE " - functions & global variables
-extern unique_ptr< Module > module;
-
-// " SCOPED " variables values
-extern map< string, AllocaInst * > namedvalues;
-
-// " FUNCTIONs " and their blueprints
-extern map< string, unique_ptr< funcproto > > functions;
-
-extern unique_ptr< legacy::FunctionPassManager > fpm;
-extern ExitOnError exitonerr;
-extern set<string> constants;
-
-Function * getfunction( string name );
-AllocaInst * createblockalloc( Function * func , StringRef var );
-
-void writelnfunc();
-void readlnfunc();
-
-
-// " PROTOTYPE " class to encapsulate the blueprint of a function ( name, arguments, ... )
-class funcproto
-{
-private:
-  string name;
-  vector< string > arguments;
-  bool isoperator;
-  unsigned precedence;
-
-public:
-  bool isprocedure;
-  // " CONSTRUCTOR "
-  funcproto( const string & n, vector<string> a, bool op = false, unsigned p = 0, bool isp = false ) :
-  name(n), arguments(move(a)), isoperator(op), precedence(p), isprocedure(isp) {}
-
-  // " CODEGEN "
-  Function * codegen();
-
-  // " GETTERS "
-  const string & getname() const;
-  bool isunary() const;
-  bool isbinary() const;
-  char operatorname() const;
-  unsigned getprecedence() const;
-};
-
-class expression;
-
-// " FUNCTION " represents a whole function definition which is made up of the blueprint (PROTOTYPE) & its body
-class funct
-{
-private:
-  unique_ptr< funcproto > proto;
-  vector< unique_ptr< expression > > body;
-
-public:
-  bool isprocedure;
-  // " CONSTRUCTOR "
-  funct( unique_ptr<funcproto> p, vector<unique_ptr<expression>> b, bool isp = false ) :
-  proto(move(p)), body(move(b)), isprocedure(isp) {}
-  // " CODEGEN"
-  Function * codegen();
-};
-
-// " BASE " class for all expressions
-class expression
-{
-public:
-  virtual ~expression() = default;
-  virtual Value * codegen() = 0;
-  virtual bool makeglobal();
-  virtual const string getname() const;
-};
-
-// " NUMBER " expression ( 21 )
-class numexpr : public expression
-{
-private:
-  int value;
-
-public:
-  numexpr( int v ) : value( v ) {}
-  Value * codegen() override;
-};
-
-// " VARIABLE " expression ( "ye" )
-class variableexpr : public expression
-{
-private:
-  string name;
-
-public:
-  variableexpr( string n ) : name(n) {}
-  Value * codegen() override;
-  const string getname() const override;
-};
-
-// " BINARY OPERATOR " expression ( & )
-class binexpr : public expression
-{
-private:
-  char op;
-  unique_ptr< expression > lhs;
-  unique_ptr< expression > rhs;
-
-public:
-  binexpr( char o, unique_ptr<expression> l, unique_ptr<expression> r ) : op(o), lhs(move(l)), rhs(move(r)) {}
-  Value * codegen() override;
-};
-
-// " CALL FUNCTION " expression ( func(a,b) )
-class callexpr : public expression
-{
-private:
-  string caller;
-  vector < unique_ptr< expression > > arguments;
-
-public:
-  callexpr( string & c, vector<unique_ptr<expression>> a ) : caller(c), arguments(move(a)) {}
-  Value * codegen() override;
-};
-
-// " IF / ELSE " expression ( if / then / else )
-class ifexpr : public expression
-{
-private:
-  unique_ptr< expression > cond;
-  vector < unique_ptr < expression > > then;
-  unique_ptr< expression > Else;
-
-public:
-  bool iselse;
-  // " CONSTRUCTOR " ( if / then / else )
-  ifexpr( unique_ptr<expression> c, vector<unique_ptr<expression>> t, unique_ptr<expression> e, bool is ) :
-  cond(move(c)), then(move(t)), Else(move(e)), iselse(is) {}
-  // " CONSTRUCTOR " ( if / then )
-  ifexpr( unique_ptr<expression> c, vector<unique_ptr<expression>> t ) :
-  cond(move(c)), then(move(t)) {}
-  Value * codegen() override;
-};
-
-// " FOR " expression ( for / in )
-class forexpr : public expression
-{
-private:
-  bool to;
-  string name;
-  unique_ptr< expression > start;
-  unique_ptr< expression > step;
-  unique_ptr< expression > end;
-  vector< unique_ptr< expression > > body;
-
-public:
-  forexpr( const string & n, unique_ptr<expression> strt, unique_ptr<expression> stp,
-           unique_ptr<expression> e, vector<unique_ptr<expression>> b, bool t ) :
-  name(n), start(move(strt)), step(move(stp)), end(move(e)), body(move(b)), to(t) {}
-  Value * codegen() override;
-};
-
-// " UNARY OPERATOR " expression ( ++ )
-class unaryexpr : public expression
-{
-private:
-  char opcode;
-  unique_ptr< expression > operand;
-
-public:
-  unaryexpr( char opc, unique_ptr<expression> oper ) : opcode(opc), operand(move(oper)) {}
-  Value * codegen() override;
-};
-
-// " VARIABLE " expression ( var / in )
-class varexpr : public expression
-{
-private:
-  vector< pair< string, unique_ptr<expression> > > variables;
-
-public:
-  varexpr( vector<pair<string, unique_ptr<expression>>> v ) : variables(move(v)) {}
-  Value * codegen() override;
-  bool makeglobal() override;
-};
-
-// " CONST " expression ( const )
-class constantexpr : public expression
-{
-private:
-  vector< pair< string, unique_ptr<expression> > > variables;
-
-public:
-  constantexpr( vector<pair<string, unique_ptr<expression>>> v ) : variables(move(v)) {}
-  Value * codegen() override;
-  bool makeglobal() override;
-};
-
-#endif //PJPPROJECT_AST_HPP
+#ifndef PJPPROJECT_AST_HPP
+#define PJPPROJECT_AST_HPP
+
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/InstCombine/InstCombine.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Verifier.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string_view>
+
+using namespace llvm;
+using namespace std;
+
+
+class funcproto;
+
+// " NODE INDEX " position of a node inside the ( astbody ) it belongs to
+typedef uint32_t nodeid;
+// a missing child ( if without else, failed parse ... )
+const nodeid nonode = UINT32_MAX;
+
+// " NODE KINDS " and the meaning of the ( astnode ) operands for each of them
+enum class nodekind : uint8_t
+{
+  // a = value
+  number,
+  // a = identifier id
+  variable,
+  // op = operator, a = lhs, b = rhs
+  binary,
+  // op = operator, a = operand
+  unary,
+  // a = function identifier id, b = list of the arguments
+  call,
+  // a = condition, b = list of the then statements, c = else statement or ( nonode )
+  ifthen,
+  // op = 1 for ( to ) 0 for ( downto ), a = variable identifier id, b = start, c = end, d = list of the body
+  forloop,
+  // a = list of ( identifier id, initializer or nonode ) pairs
+  vars,
+  consts
+};
+
+// " AST NODE " one expression, the children are indices of the same ( astbody )
+struct astnode
+{
+  nodekind kind;
+  int16_t op;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  uint32_t d;
+};
+
+// " NODE LIST " view of a list stored in ( astbody::lists )
+class nodelist
+{
+private:
+  const uint32_t * items;
+  uint32_t count;
+
+public:
+  nodelist( const uint32_t * i, uint32_t c ) : items(i), count(c) {}
+
+  const uint32_t * begin() const { return items; }
+  const uint32_t * end() const { return items + count; }
+  size_t size() const { return count; }
+  uint32_t operator[]( size_t index ) const { return items[index]; }
+};
+
+// " AST BODY " the whole tree of one top level item ( function, globals ... ) in two flat arrays.
+// The parser appends children before their parent, so a forward walk over ( nodes ) visits the
+// tree in post-order and passes that don't care about the shape can simply loop over it
+class astbody
+{
+public:
+  vector< astnode > nodes;
+  // lists of children, each one stored as its length followed by the items
+  vector< uint32_t > lists;
+  // symbol slot of every node filled in by the name resolution, see ( Symbols.hpp )
+  vector< uint32_t > slots;
+
+  const astnode & operator[]( nodeid n ) const { return nodes[n]; }
+
+  nodeid add( nodekind kind, int op = 0, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0 )
+  {
+    nodes.push_back({ kind, (int16_t) op, a, b, c, d });
+    return nodes.size() - 1;
+  }
+
+  // Copies ( items ) to the end of ( lists ) and returns the position of the copy
+  uint32_t addlist( const vector<uint32_t> & items )
+  {
+    uint32_t offset = lists.size();
+    lists.push_back(items.size());
+    lists.insert(lists.end(), items.begin(), items.end());
+    return offset;
+  }
+
+  nodelist list( uint32_t offset ) const
+  { return nodelist(lists.data() + offset + 1, lists[offset]); }
+
+  void clear()
+  {
+    nodes.clear();
+    lists.clear();
+    slots.clear();
+  }
+};
+
+// " AST STATISTICS " sizes of the trees built so far ( --ast-stats )
+class aststatistics
+{
+private:
+  size_t items;
+  size_t nodes;
+  size_t listwords;
+  // bytes of the largest single tree
+  size_t peakbytes;
+
+public:
+  aststatistics() : items(0), nodes(0), listwords(0), peakbytes(0) {}
+
+  void record( const astbody & ast );
+  void print( FILE * out ) const;
+};
+
+extern aststatistics aststats;
+
+// LLVM " CONTEXT "
+extern unique_ptr< LLVMContext > context;
+// LLVM " BUILDER "
+extern unique_ptr< IRBuilder<> > builder;
+// LLVM " MODULE " - functions & global variables
+extern unique_ptr< Module > module;
+
+extern unique_ptr< legacy::FunctionPassManager > fpm;
+extern ExitOnError exitonerr;
+
+// " FUNCTION HASHES " of the defined functions, collected while ( hashfunctions ) is set ( --incremental ).
+// Stable across compilations, covers the function's AST and the signatures of the symbols it uses,
+// main chains the hashes of the top level statements it's made of
+extern bool hashfunctions;
+extern map< const Function *, string > functionhashes;
+
+AllocaInst * createblockalloc( Function * func , StringRef var );
+
+void writelnfunc();
+void readlnfunc();
+
+
+// " PROTOTYPE " class to encapsulate the blueprint of a function ( name, arguments, ... )
+class funcproto
+{
+private:
+  string name;
+  vector< string > arguments;
+  bool isoperator;
+  unsigned precedence;
+
+public:
+  bool isprocedure;
+  // " CONSTRUCTOR "
+  funcproto( const string & n, vector<string> a, bool op = false, unsigned p = 0, bool isp = false ) :
+  name(n), arguments(move(a)), isoperator(op), precedence(p), isprocedure(isp) {}
+
+  // " CODEGEN "
+  Function * codegen();
+
+  // " GETTERS "
+  const string & getname() const;
+  const vector< string > & getarguments() const;
+  bool isunary() const;
+  bool isbinary() const;
+  char operatorname() const;
+  unsigned getprecedence() const;
+};
+
+// " FUNCTION " represents a whole function definition which is made up of the blueprint (PROTOTYPE) & its body
+class funct
+{
+private:
+  unique_ptr< funcproto > proto;
+  astbody ast;
+  // list of the statements in ( ast )
+  uint32_t body;
+
+public:
+  bool isprocedure;
+  // symbol slot of the first argument and the number of slots the arguments and locals take, set by codegen
+  uint32_t framebase;
+  uint32_t framesize;
+  // " CONSTRUCTOR "
+  funct( unique_ptr<funcproto> p, astbody a, uint32_t b, bool isp = false ) :
+  proto(move(p)), ast(move(a)), body(b), isprocedure(isp), framebase(0), framesize(0) {}
+  // " CODEGEN"
+  Function * codegen();
+
+  // " GETTERS "
+  const funcproto & getproto() const;
+  const astbody & getast() const;
+  uint32_t getbody() const;
+  // SHA-1 of the resolved function as 40 hex digits, see ( functionhashes )
+  string hash() const;
+};
+
+// " NODE " CODEGEN, switches on the kind of the node, the names must be resolved already
+Value * codegen( const astbody & ast, nodeid n );
+// " GLOBAL " var / const declarations at the top level of the program
+bool makeglobal( astbody & ast, nodeid n );
+
+#endif //PJPPROJECT_AST_HPP
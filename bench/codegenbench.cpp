@@ -0,0 +1,83 @@
+// Codegen benchmark, parses and generates the IR of a large synthetic program one function at a
+// time and prints the time spent in the parser and in codegen separately
+//
+//   codegenbench [functions]    defaults to 20000 functions
+
+#include "../Parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+using namespace std::chrono;
+
+// Generates a program with ( functions ) functions, each one calling the previous one
+static string generate( int functions )
+{
+  ostringstream out;
+  out << "program bench;\n";
+  for( int f = 0; f < functions; f++ )
+  {
+    out << "function f" << f << "( a : integer; b : integer ) : integer;\n";
+    out << "var x : integer;\n";
+    out << "begin\n";
+    out << "  x := a + " << f << ";\n";
+    out << "  for i := 1 to a do\n";
+    out << "  begin\n";
+    out << "    writeln(i * b + " << f << " - ( a / 3 ));\n";
+    out << "  end;\n";
+    out << "  if a > b then writeln(a - b) else writeln(( b - a ) * ( x + 1 ));\n";
+    if( f > 0 )
+    { out << "  writeln(f" << f - 1 << "(a + 1, b * 2 - " << f << "));\n"; }
+    out << "  a * b + x - " << f << "\n";
+    out << "end;\n";
+  }
+  out << "begin\n  writeln(f" << functions - 1 << "(1, 2));\nend.\n";
+  return out.str();
+}
+
+int main( int argc, char * argv[] )
+{
+  int functions = argc > 1 ? max(1, atoi(argv[1])) : 20000;
+
+  string text = generate(functions);
+  tokenize(text.data(), text.data() + text.size(), tokens);
+
+  // only the IR generation is measured, not the per function passes
+  InitializeModuleAndPassManager(false);
+  readlnfunc();
+  writelnfunc();
+
+  // PROGRAM NAME ;
+  getNextToken();
+  getNextToken();
+  getNextToken();
+
+  duration<double> parsetime(0);
+  duration<double> codegentime(0);
+  int generated = 0;
+  while( currenttok != tok_eof && currenttok != tok_begin )
+  {
+    if( currenttok != tok_function )
+    {
+      getNextToken();
+      continue;
+    }
+
+    auto start = steady_clock::now();
+    auto func = ParseDefinition();
+    auto parsed = steady_clock::now();
+    if( func && func->codegen() )
+    { generated++; }
+    codegentime += steady_clock::now() - parsed;
+    parsetime += parsed - start;
+  }
+
+  printf("%zu bytes, %zu tokens, %d of %d functions generated\n", text.size(), tokens.size(), generated, functions);
+  aststats.print(stdout);
+  printf("parse   %8.3f s\n", parsetime.count());
+  printf("codegen %8.3f s %12.0f functions/s\n", codegentime.count(), generated / codegentime.count());
+  return generated == functions ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#!/bin/bash
+# Runtime I/O benchmark, the time bench/iowrite.mila takes to write ( count ) integers and the time of it piping
+# them into bench/ioread.mila, which reads them back and sums them. Both programs are linked with the buffered
+# runtime ( fce.c ) and with the previous printf / scanf one ( bench/fcestdio.c ), and compiled with the runtime
+# inlined from the bitcode mila embeds
+#
+#   bench/iobench.sh [count]    defaults to 10^8 integers
+#
+# CC picks the C compiler linking the runtimes
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/.." >/dev/null 2>&1 && pwd )"
+MILA="${DIR}/build/mila"
+CC="${CC:-clang}"
+
+count=${1:-100000000}
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+for program in iowrite ioread; do
+    "$MILA" --external-runtime -o "$work/$program.o" "${DIR}/bench/$program.mila" || exit 1
+    "$CC" -O2 "$work/$program.o" "${DIR}/fce.c" -o "$work/$program-buffered" || exit 1
+    "$CC" -O2 "$work/$program.o" "${DIR}/bench/fcestdio.c" -o "$work/$program-stdio" || exit 1
+    "$MILA" --emit=exe -o "$work/$program-inlined" "${DIR}/bench/$program.mila" || exit 1
+done
+
+# seconds the command ( $1 ) takes
+measure()
+{
+    local start=$(date +%s%N)
+    bash -c "$1" > /dev/null
+    printf "%12.2f" "$(( $(date +%s%N) - start ))e-9"
+}
+
+printf "%-12s%12s%12s   seconds for %d integers\n" "runtime" "write" "write+read" "$count"
+for runtime in stdio buffered inlined; do
+    printf "%-12s" "$runtime"
+    measure "echo $count | '$work/iowrite-$runtime' > /dev/null"
+    measure "echo $count | '$work/iowrite-$runtime' | '$work/ioread-$runtime'"
+    echo
+done
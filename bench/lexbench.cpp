@@ -0,0 +1,220 @@
+// Lexer microbenchmark, prints tokens / second of the previous stdio based lexer
+// ( getchar, string compares for keywords ), of the current gettok(), of tokenize() with
+// every scanning kernel set the CPU supports and of tokenize() run on several threads
+//
+//   lexbench [-jN]                  lexes a generated program of ~1M lines
+//   lexbench [-jN] file.mila ...    lexes the given programs
+//
+// -jN sets the number of threads of the parallel run, defaults to the number of cores
+
+#include "../Lexer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono;
+
+static unsigned threads = max(1u, thread::hardware_concurrency());
+
+// " PREVIOUS LEXER ", kept here as the baseline to compare against
+namespace legacy
+{
+  static FILE * in;
+  static int input;
+  static string idname;
+  static int value;
+
+  static int peekc()
+  {
+    int c = fgetc(in);
+    ungetc(c, in);
+    return c;
+  }
+
+  static bool twocharop( char c )
+  { return c != 59 && ( ( c > 57 && c < 67 ) || c == 33 || c == 124 ); }
+
+  static int gettok()
+  {
+    while( isspace(input) )
+    { input = fgetc(in); }
+
+    if( isalpha(input) )
+    {
+      idname = input;
+      while( isalnum(input = fgetc(in)) )
+      { idname += input; }
+      static const char * keywords[] = { "begin", "end", "const", "procedure", "forward", "function",
+                                         "if", "then", "else", "program", "while", "exit", "var",
+                                         "integer", "for", "do", "to", "downto" };
+      static const int tokens[] = { tok_begin, tok_end, tok_const, tok_procedure, tok_forward, tok_function,
+                                    tok_if, tok_then, tok_else, tok_program, tok_while, tok_exit, tok_var,
+                                    tok_integer, tok_for, tok_do, tok_to, tok_downto };
+      for( int i = 0; i < 18; i++ )
+      {
+        if( idname == keywords[i] )
+        { return tokens[i]; }
+      }
+      return tok_identifier;
+    }
+
+    if( isdigit(input) )
+    {
+      string number;
+      do
+      {
+        number += input;
+        input = fgetc(in);
+      } while( isdigit(input) );
+      value = (int) strtod(number.c_str(), nullptr);
+      return tok_number;
+    }
+
+    if( input == '&' || input == '$' )
+    {
+      int base = input == '&' ? 8 : 16;
+      input = fgetc(in);
+      string number;
+      do
+      {
+        number += input;
+        input = fgetc(in);
+      } while( isdigit(input) || ( base == 16 && isalnum(input) ) );
+      char * tmp;
+      value = (int) strtol(number.c_str(), &tmp, base);
+      return tok_number;
+    }
+
+    if( input == '#' )
+    {
+      do
+      { input = fgetc(in); }
+      while( input != EOF && input != '\n' && input != '\r' );
+      if( input != EOF )
+      { return gettok(); }
+    }
+
+    if( twocharop(input) )
+    {
+      static const char * operations[] = { "!=", "<=", ">=", ":=", "||", "==" };
+      static const int tokens[] = { tok_notequal, tok_lessequal, tok_greaterequal, tok_assign, tok_or, tok_eq };
+      string operation;
+      operation = input;
+      while( twocharop(peekc()) )
+      {
+        input = fgetc(in);
+        operation += input;
+        for( int i = 0; i < 6; i++ )
+        {
+          if( operation == operations[i] )
+          {
+            input = fgetc(in);
+            return tokens[i];
+          }
+        }
+      }
+    }
+
+    if( input == EOF )
+    { return tok_eof; }
+
+    int ascii = input;
+    input = fgetc(in);
+    return ascii;
+  }
+}
+
+// Generates a program with ( functions ) functions of a few statements each
+static string generate( int functions )
+{
+  ostringstream out;
+  out << "program bench;\n";
+  for( int f = 0; f < functions; f++ )
+  {
+    out << "# function number " << f << "\n";
+    out << "function f" << f << "( a : integer; b : integer ) : integer;\n";
+    out << "var x, y : integer;\n";
+    out << "begin\n";
+    out << "  x := a * " << f << " + $1F;\n";
+    out << "  y := b - &17;\n";
+    out << "  if x <= y then x := y;\n";
+    out << "  for i := 1 to 10 do begin y := y + i; end\n";
+    out << "  f" << f << " := x + y;\n";
+    out << "end;\n";
+  }
+  out << "begin\n  writeln(f0(1, 2));\nend.\n";
+  return out.str();
+}
+
+static void report( const char * name, size_t tokens, duration<double> elapsed )
+{
+  printf("%-10s %10zu tokens %8.3f s %12.0f tokens/s\n", name, tokens, elapsed.count(), tokens / elapsed.count());
+}
+
+static void bench( const string & text )
+{
+  printf("%zu bytes\n", text.size());
+
+  legacy::in = fmemopen((void *) text.data(), text.size(), "r");
+  legacy::input = ' ';
+  auto start = steady_clock::now();
+  size_t before = 0;
+  while( legacy::gettok() != tok_eof )
+  { before++; }
+  report("previous", before, steady_clock::now() - start);
+  fclose(legacy::in);
+
+  setlexerinput(text.data(), text.data() + text.size());
+  start = steady_clock::now();
+  size_t after = 0;
+  while( gettok() != tok_eof )
+  { after++; }
+  report("current", after, steady_clock::now() - start);
+
+  tokenstream sequential;
+  for( auto * kernels : supportedkernels() )
+  {
+    start = steady_clock::now();
+    tokenize(text.data(), text.data() + text.size(), sequential, 1, *kernels);
+    report(kernels->name, sequential.size(), steady_clock::now() - start);
+  }
+
+  tokenstream parallel;
+  start = steady_clock::now();
+  tokenize(text.data(), text.data() + text.size(), parallel, threads);
+  report("parallel", parallel.size(), steady_clock::now() - start);
+
+  printf("%u threads, %s to the sequential token stream\n", threads, sequential == parallel ? "identical" : "DIFFERENT");
+}
+
+int main( int argc, char * argv[] )
+{
+  int first = 1;
+  if( argc > 1 && strncmp(argv[1], "-j", 2) == 0 )
+  {
+    threads = max(1, atoi(argv[1] + 2));
+    first++;
+  }
+
+  if( argc <= first )
+  {
+    bench(generate(100000));
+    return 0;
+  }
+
+  for( int i = first; i < argc; i++ )
+  {
+    ifstream file(argv[i]);
+    stringstream text;
+    text << file.rdbuf();
+    printf("%s: ", argv[i]);
+    bench(text.str());
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+#!/bin/bash
+# Optimization level benchmark, compiles every program at -O0 .. -O3, -Os and -Oz and prints the
+# time of running each binary ( runs ) times in a row, programs that don't compile are skipped
+#
+#   bench/optbench.sh [runs] [file.mila ...]    defaults to 200 runs of samples/*.mila
+#
+# Programs read their input from bench/optbench.in, CC picks the C compiler linking fce.c
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/.." >/dev/null 2>&1 && pwd )"
+MILA="${DIR}/build/mila"
+CC="${CC:-clang}"
+LEVELS="0 1 2 3 s z"
+
+runs=200
+if [[ $# -gt 0 && $1 =~ ^[0-9]+$ ]]; then
+    runs=$1
+    shift
+fi
+programs=("$@")
+if [[ ${#programs[@]} -eq 0 ]]; then
+    programs=("${DIR}"/samples/*.mila)
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+"$CC" -c -O2 "${DIR}/fce.c" -o "$work/fce.o" || exit 1
+
+printf "%-24s" "program"
+for l in $LEVELS; do printf "%10s" "-O$l"; done
+printf "   ms for %d runs\n" "$runs"
+
+for program in "${programs[@]}"; do
+    name=$(basename "$program" .mila)
+    line=$(printf "%-24s" "$name")
+    for l in $LEVELS; do
+        binary="$work/$name-O$l"
+        if ! "$MILA" -O$l -o "$binary.o" "$program" 2>/dev/null || ! "$CC" "$binary.o" "$work/fce.o" -o "$binary" 2>/dev/null; then
+            line=""
+            break
+        fi
+        start=$(date +%s%N)
+        for (( r = 0; r < runs; r++ )); do
+            "$binary" < "${DIR}/bench/optbench.in" > /dev/null
+        done
+        line+=$(printf "%10.1f" "$(( $(date +%s%N) - start ))e-6")
+    done
+    if [[ -n $line ]]; then
+        echo "$line"
+    else
+        printf "%-24s%10s\n" "$name" "skipped"
+    fi
+done
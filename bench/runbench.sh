@@ -0,0 +1,47 @@
+#!/bin/bash
+# End to end latency of running a program, the mila script ( compile, link with fce.c, run the binary )
+# against build/mila --run ( compile in memory, run in the compiler's process ), averaged over ( runs )
+#
+#   bench/runbench.sh [runs] [file.mila ...]    defaults to 20 runs of tests/*.mila
+#
+# Programs read their input from bench/optbench.in
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/.." >/dev/null 2>&1 && pwd )"
+MILA="${DIR}/build/mila"
+
+runs=20
+if [[ $# -gt 0 && $1 =~ ^[0-9]+$ ]]; then
+    runs=$1
+    shift
+fi
+programs=("$@")
+if [[ ${#programs[@]} -eq 0 ]]; then
+    programs=("${DIR}"/tests/*.mila)
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# average milliseconds of running "$@" ( runs ) times
+measure()
+{
+    local start=$(date +%s%N)
+    for (( r = 0; r < runs; r++ )); do
+        "$@" < "${DIR}/bench/optbench.in" > /dev/null 2>&1
+    done
+    printf "%10.1f" "$(( ( $(date +%s%N) - start ) / runs ))e-6"
+}
+
+script()
+{
+    rm -f "$work/a" && bash "${DIR}/mila" -o "$work/a" "$1" && "$work/a"
+}
+
+printf "%-24s%10s%10s%10s   ms per run\n" "program" "script" "--run" "-O0 --run"
+for program in "${programs[@]}"; do
+    printf "%-24s" "$(basename "$program" .mila)"
+    measure script "$program"
+    measure "$MILA" --run "$program"
+    measure "$MILA" -O0 --run "$program"
+    echo
+done
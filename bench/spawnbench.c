@@ -0,0 +1,40 @@
+// Process startup microbenchmark, the average time from fork until the program exited and was waited for
+//
+//   spawnbench runs program [arguments]
+//
+// The program's stdout goes to /dev/null, prints microseconds per run
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char * argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s runs program [arguments]\n", argv[0]);
+        return 2;
+    }
+    int runs = atoi(argv[1]);
+    int null = open("/dev/null", O_WRONLY);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < runs; r++) {
+        pid_t child = fork();
+        if (child == 0) {
+            dup2(null, 1);
+            execv(argv[2], argv + 2);
+            _exit(127);
+        }
+        int status;
+        if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "%s failed\n", argv[2]);
+            return 1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("%.1f\n", seconds / runs * 1e6);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Startup benchmark of the compiled programs, the time from fork and exec until bench/spawn.mila exited, averaged
+# over ( runs ). The program is linked as mila links it by default ( dynamically with the C library ), statically with
+# the C library and with --freestanding ( static, no C library )
+#
+#   bench/spawnbench.sh [runs]    defaults to 10000 runs
+#
+# CC picks the C compiler of the driver ( bench/spawnbench.c ) and of the static link
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/.." >/dev/null 2>&1 && pwd )"
+MILA="${DIR}/build/mila"
+CC="${CC:-clang}"
+
+runs=${1:-10000}
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+"$CC" -O2 "${DIR}/bench/spawnbench.c" -o "$work/spawnbench" || exit 1
+"$MILA" --emit=exe -o "$work/dynamic" "${DIR}/bench/spawn.mila" || exit 1
+"$MILA" -o "$work/spawn.o" "${DIR}/bench/spawn.mila" || exit 1
+"$CC" -static "$work/spawn.o" -o "$work/static" || exit 1
+"$MILA" --emit=exe --freestanding -o "$work/freestanding" "${DIR}/bench/spawn.mila" || exit 1
+
+printf "%-14s%12s%10s   for %d runs\n" "executable" "bytes" "us" "$runs"
+for kind in dynamic static freestanding; do
+    printf "%-14s%12s%10s\n" "$kind" "$(stat -c %s "$work/$kind")" "$("$work/spawnbench" "$runs" "$work/$kind")"
+done
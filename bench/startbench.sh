@@ -0,0 +1,50 @@
+#!/bin/bash
+# Startup latency benchmark, the time from starting the compiler on an empty program until the first byte of its
+# output arrives, averaged over ( runs ). An empty program leaves what every compilation pays before doing any work:
+# loading the compiler, LLVM's static constructors and setting up the target
+#
+#   bench/startbench.sh [runs] [--record]    defaults to 200 runs
+#
+# MILA picks the compiler ( build/mila ), with MILA_SERVER set build/mila-client is measured as well. --record
+# appends the result to bench/startbench.tsv with the date, the commit and BUILD ( a note on how mila was built )
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )/.." >/dev/null 2>&1 && pwd )"
+MILA="${MILA:-${DIR}/build/mila}"
+
+runs=200
+if [[ $# -gt 0 && $1 =~ ^[0-9]+$ ]]; then
+    runs=$1
+    shift
+fi
+record=n
+if [[ $# -gt 0 && $1 == --record ]]; then
+    record=y
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+printf 'program empty;\n\nbegin\nend.\n' > "$work/empty.mila"
+
+# average milliseconds until "$@" writes its first byte, ( runs ) times
+measure()
+{
+    local start=$(date +%s%N)
+    for (( r = 0; r < runs; r++ )); do
+        "$@" 2> /dev/null | head -c 1 > /dev/null
+    done
+    printf "%.2f" "$(( ( $(date +%s%N) - start ) / runs ))e-6"
+}
+
+object=$(measure "$MILA" -o - "$work/empty.mila")
+ir=$(measure "$MILA" --emit=ir -o - "$work/empty.mila")
+printf "%-14s%10s ms\n" "object" "$object" "ir" "$ir"
+client="-"
+if [[ -n "${MILA_SERVER:-}" ]]; then
+    client=$(measure "$(dirname "$MILA")/mila-client" -o - "$work/empty.mila")
+    printf "%-14s%10s ms\n" "mila-client" "$client"
+fi
+
+if [[ $record == y ]]; then
+    commit=$(git -C "$DIR" rev-parse --short HEAD 2> /dev/null || echo "-")
+    printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$(date +%F)" "$commit" "${BUILD:--}" "$runs" "$object" "$ir" "$client" >> "${DIR}/bench/startbench.tsv"
+fi
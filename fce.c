@@ -1,14 +1,169 @@
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+// " RUNTIME " writeln, write and readln of the Mila programs. The output is collected in one large buffer and the
+// input read in large blocks, every value is formatted and parsed here rather than by printf and scanf. mila links
+// the bitcode of this file into the programs ( Runtime.cpp ), it has no constructors and only exports the three
+
+// fce.c defines its own write, so the read and isatty of unistd.h are declared by hand
+extern ssize_t read(int fd, void * buffer, size_t count);
+extern int isatty(int fd);
+
+// " OUTPUT " written when the buffer is full, before waiting for input and at the exit. On a terminal every line
+// is written right away so a long running program shows its progress, pipes and files keep the large buffer
+#define OUTPUT_SIZE (1 << 16)
+// the longest value with its newline, "-2147483648\n"
+#define VALUE_SIZE 12
+
+static char output[OUTPUT_SIZE];
+static size_t outputlength = 0;
+static int flushregistered = 0;
+static int interactive = 0;
+
+static const char digitpairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void flushoutput(void) {
+    if (outputlength > 0) {
+        fwrite(output, 1, outputlength, stdout);
+        outputlength = 0;
+    }
+    fflush(stdout);
+}
+
+// Makes room for one more value, the first one also registers the flush at the exit and looks at the stdout
+static void reserve(void) {
+    if (!flushregistered) {
+        atexit(flushoutput);
+        flushregistered = 1;
+        interactive = isatty(1);
+    }
+    if (outputlength > OUTPUT_SIZE - VALUE_SIZE)
+        flushoutput();
+}
+
+// Appends ( x ) in decimal, two digits at a time from the end
+static void append(int x) {
+    char digits[VALUE_SIZE];
+    char * end = digits + sizeof(digits);
+    char * p = end;
+    unsigned int value = x < 0 ? 0u - (unsigned int) x : (unsigned int) x;
+    while (value >= 100) {
+        unsigned int pair = value % 100;
+        value /= 100;
+        p -= 2;
+        memcpy(p, digitpairs + 2 * pair, 2);
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, digitpairs + 2 * value, 2);
+    } else
+        *--p = (char) ('0' + value);
+    if (x < 0)
+        *--p = '-';
+    memcpy(output + outputlength, p, end - p);
+    outputlength += end - p;
+}
 
 int writeln(int x) {
-    printf("%d\n", x);
+    reserve();
+    append(x);
+    output[outputlength++] = '\n';
+    if (interactive)
+        flushoutput();
     return 0;
 }
 int write(int x) {
-    printf("%d", x);
+    reserve();
+    append(x);
     return 0;
 }
+
+// " INPUT " read in blocks of whatever is available, a terminal gives a line at a time
+#define INPUT_SIZE (1 << 16)
+
+static char input[INPUT_SIZE];
+static size_t inputposition = 0;
+static size_t inputlength = 0;
+
+// Next byte of the input or EOF, the output is written first when it has to wait so prompts show up
+static int nextbyte(void) {
+    if (inputposition == inputlength) {
+        ssize_t n;
+        flushoutput();
+        do
+            n = read(0, input, sizeof(input));
+        while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return EOF;
+        inputlength = (size_t) n;
+        inputposition = 0;
+    }
+    return (unsigned char) input[inputposition++];
+}
+
+static int isspacebyte(int c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// readln for a number that may go on in the next block, byte by byte. Returns 0 if there's no number
+static int readlnslow(int *value) {
+    int c = nextbyte();
+    while (isspacebyte(c))
+        c = nextbyte();
+    int negative = c == '-';
+    if (c == '-' || c == '+')
+        c = nextbyte();
+    if (c < '0' || c > '9') {
+        if (c != EOF)
+            inputposition--;
+        return 0;
+    }
+    unsigned int digits = 0;
+    while (c >= '0' && c <= '9') {
+        digits = digits * 10 + (unsigned int) (c - '0');
+        c = nextbyte();
+    }
+    // the byte after the number is left for the next read
+    if (c != EOF)
+        inputposition--;
+    *value = (int) (negative ? 0u - digits : digits);
+    return 1;
+}
+
+// Reads the next integer like scanf("%d"), ( x ) keeps its value if there is none. A number followed by another
+// byte in the block is parsed right from the buffer. Only readln itself stores through ( x ), once the compiler
+// inlines it the variable can stay in a register
 int readln(int *x) {
-    scanf("%d", x);
+    const char * p = input + inputposition;
+    const char * end = input + inputlength;
+    while (p < end && isspacebyte(*p))
+        p++;
+    if (p < end) {
+        int negative = *p == '-';
+        if (*p == '-' || *p == '+')
+            p++;
+        const char * digits = p;
+        unsigned int value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (unsigned int) (*p - '0');
+            p++;
+        }
+        if (p < end && p > digits) {
+            inputposition = (size_t) (p - input);
+            *x = (int) (negative ? 0u - value : value);
+            return 0;
+        }
+    }
+    int value;
+    if (readlnslow(&value))
+        *x = value;
     return 0;
 }
@@ -0,0 +1,141 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+// " FREESTANDING START " for the executables of --freestanding, linked statically without the C library. It starts
+// the program on its own and gives the runtime ( fce.c ) the few functions of the C library it calls, each of them a
+// raw Linux system call. x86-64 Linux only
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "fcestart.c only starts programs on x86-64 Linux"
+#endif
+
+int main(void);
+
+// " SYSTEM CALLS "
+#define SYS_READ 0
+#define SYS_WRITE 1
+#define SYS_IOCTL 16
+#define SYS_EXIT_GROUP 231
+
+static long syscall3(long number, long a, long b, long c) {
+    long result;
+    __asm__ volatile("syscall"
+                     : "=a"(result)
+                     : "a"(number), "D"(a), "S"(b), "d"(c)
+                     : "rcx", "r11", "memory");
+    return result;
+}
+
+static int error = 0;
+
+int * __errno_location(void) {
+    return &error;
+}
+
+ssize_t read(int fd, void * buffer, size_t count) {
+    long n = syscall3(SYS_READ, fd, (long) buffer, (long) count);
+    if (n < 0) {
+        error = (int) -n;
+        return -1;
+    }
+    return n;
+}
+
+// the runtime writes every line right away to a terminal, one is an fd the TCGETS ioctl works on
+#define TCGETS 0x5401
+
+int isatty(int fd) {
+    // room for the kernel's struct termios
+    char termios[64];
+    long n = syscall3(SYS_IOCTL, fd, TCGETS, (long) termios);
+    if (n < 0) {
+        error = (int) -n;
+        return 0;
+    }
+    return 1;
+}
+
+// " OUTPUT " the runtime buffers the output itself and only writes to the stdout, fwrite writes right away
+FILE * stdout = NULL;
+
+size_t fwrite(const void * data, size_t size, size_t count, FILE * stream) {
+    const char * p = data;
+    size_t left = size * count;
+    (void) stream;
+    while (left > 0) {
+        long n = syscall3(SYS_WRITE, 1, (long) p, (long) left);
+        if (n == -EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        p += n;
+        left -= (size_t) n;
+    }
+    return size ? (size * count - left) / size : 0;
+}
+
+int fflush(FILE * stream) {
+    (void) stream;
+    return 0;
+}
+
+// " EXIT " functions registered by atexit run after main in the reverse order
+#define EXIT_HANDLERS 32
+
+static void (*handlers[EXIT_HANDLERS])(void);
+static int handlercount = 0;
+
+int atexit(void (*handler)(void)) {
+    if (handlercount == EXIT_HANDLERS)
+        return -1;
+    handlers[handlercount++] = handler;
+    return 0;
+}
+
+// " MEMORY " the compilers call these for copies and fills of any size, built with -ffreestanding so the loops
+// don't turn into calls of themselves
+void * memcpy(void * destination, const void * source, size_t size) {
+    char * d = destination;
+    const char * s = source;
+    while (size--)
+        *d++ = *s++;
+    return destination;
+}
+
+void * memmove(void * destination, const void * source, size_t size) {
+    char * d = destination;
+    const char * s = source;
+    if (d < s)
+        while (size--)
+            *d++ = *s++;
+    else
+        while (size--)
+            d[size] = s[size];
+    return destination;
+}
+
+void * memset(void * destination, int value, size_t size) {
+    unsigned char * d = destination;
+    while (size--)
+        *d++ = (unsigned char) value;
+    return destination;
+}
+
+// " START " the kernel jumps to _start with an aligned stack, there's nothing to set up for Mila programs
+__attribute__((used, noreturn)) static void start(void) {
+    int code = main();
+    while (handlercount > 0)
+        handlers[--handlercount]();
+    for (;;)
+        syscall3(SYS_EXIT_GROUP, code, 0, 0);
+}
+
+__asm__(".text\n"
+        ".global _start\n"
+        "_start:\n"
+        "    xor %ebp, %ebp\n"
+        "    and $-16, %rsp\n"
+        "    call start\n"
+        "    hlt\n");
@@ -1,22 +1,28 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetRegistry.h"
-#include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include <algorithm>
@@ -31,44 +37,430 @@
 #include <utility>
 #include <vector>
 
+#include "Cache.hpp"
+#include "Incremental.hpp"
+#include "Jit.hpp"
+#include "Link.hpp"
+#include "Optimizer.hpp"
 #include "Parser.hpp"
+#include "Pipeline.hpp"
+#include "Runtime.hpp"
+#include "Server.hpp"
+#include "Targets.hpp"
+#include "Tiered.hpp"
 
 
-int main (int argc, char *argv[])
+// " OUTPUT KINDS " of --emit, the default output file gets the matching extension
+enum class emitkind { ir, bitcode, assembly, object, executable };
+
+static const char * extensionof( emitkind emit )
+{
+  switch( emit )
+  {
+    case emitkind::ir:
+      return ".ll";
+    case emitkind::bitcode:
+      return ".bc";
+    case emitkind::assembly:
+      return ".s";
+    case emitkind::object:
+      return ".o";
+    case emitkind::executable:
+      return "";
+  }
+  return ".o";
+}
+
+// " OPTIONS " printed by --help and after an option compile doesn't know
+static const char * usage =
+  "usage: mila [options] [program.mila]   ( the stdin without a program )\n"
+  "  -o <file>, -o -                 output file or the stdout\n"
+  "  --emit=ir|bc|asm|obj|exe        kind of the output, obj by default\n"
+  "  -O0 -O1 -O2 -O3 -Os -Oz         optimization level, -O2 by default\n"
+  "  -mcpu=<cpu> -mattr=<features>   CPU and its features, -mcpu=native for the host's\n"
+  "  --target=<triple>               compile for another target than the host\n"
+  "  --runtime=<object> --external-runtime --linker=<driver> --freestanding\n"
+  "  --run --tiered --tier-threshold=<n> --tier-stats\n"
+  "  --cache-dir=<dir> --cache-stats --incremental=<dir> --jobs=<n> --pipeline\n"
+  "  --server[=<socket>] --connect[=<socket>]\n"
+  "  --lex-threads=<n> --lex-check --ast-stats --help\n";
+
+// Opens the output file ( path ) or the stdout for "-", prints why it couldn't be opened
+static unique_ptr< raw_fd_ostream > openoutput( const string & path, emitkind emit )
 {
-  BinopPrecedence['='] = 2;
-  BinopPrecedence['>'] = 10;
-  BinopPrecedence['<'] = 10;
-  BinopPrecedence[tok_greaterequal] = 10;
-  BinopPrecedence[tok_lessequal] = 10;
-  BinopPrecedence[tok_notequal] = 10;
-  BinopPrecedence['+'] = 20;
-  BinopPrecedence['-'] = 20;
-  BinopPrecedence['*'] = 40;
-  BinopPrecedence['/'] = 40;
+  error_code EC;
+  auto dest = make_unique<raw_fd_ostream>(path, EC, emit == emitkind::ir || emit == emitkind::assembly ? sys::fs::OF_Text : sys::fs::OF_None);
+  if( EC )
+  {
+      errs() << "Could not open file: " << path << ": " << EC.message() << "\n";
+      return nullptr;
+  }
+  return dest;
+}
+
+// Features of the host CPU as a -mattr list, "+avx2,+popcnt,-avx512f,..."
+static string hostfeatures()
+{
+  StringMap<bool> features;
+  SubtargetFeatures list;
+  if( sys::getHostCPUFeatures(features) )
+  {
+    for( auto & f : features )
+    { list.AddFeature(f.first(), f.second); }
+  }
+  return list.getString();
+}
+
+// The whole compilation the arguments ( argc, argv ) ask for, in this process or in one the server forked
+static int compile( int argc, char * argv[] )
+{
+  const char * inputFile = nullptr;
+  // empty picks the name of the input with the extension of ( emit ), "-" is the stdout
+  string outputFile;
+  emitkind emit = emitkind::object;
+  optlevel level = optlevel::O2;
+  // generic cpu without any additional features unless -mcpu / -mattr say otherwise, empty for another --target
+  // leaves the CPU to its backend
+  string CPU;
+  string Features;
+  // --emit=exe links with the runtime object next to the compiler by running the C compiler's driver
+  string compiler = sys::fs::getMainExecutable(argv[0], (void *) &extensionof);
+  string runtime = defaultruntime(compiler);
+  string linker = "cc";
+  // a static executable without the C library, started by the start object next to the compiler
+  bool freestanding = false;
+  string start = defaultstart(compiler);
+  // the runtime is declared only and linked from an object ( --external-runtime or --runtime ) rather than
+  // compiled into the module from the embedded bitcode
+  bool externalRuntime = false;
+  // the host's triple unless --target asks for another one
+  string TargetTriple = sys::getDefaultTargetTriple();
+  // 0 lets the lexer use every core on large inputs
+  unsigned lexThreads = 0;
+  bool lexCheck = false;
+  bool astStats = false;
+  // compile in memory and run the program instead of writing any output
+  bool run = false;
+  // interpret the program and JIT compile its hot functions ( --tiered )
+  bool tiered = false;
+  uint32_t tierThreshold = 1000;
+  bool tierStats = false;
+  // reuse outputs of earlier compilations of the same source with the same options
+  const char * cacheEnv = getenv("MILA_CACHE_DIR");
+  string cacheDir = cacheEnv ? cacheEnv : "";
+  bool cacheStats = false;
+  // store of the objects of single functions, only the changed ones get compiled again
+  string incrementalDir;
+  // split the module into parts optimized and compiled on this many threads, 0 uses every core
+  bool split = false;
+  unsigned jobs = 1;
+  // optimize and compile the functions on other threads while the parser goes on
+  bool pipelined = false;
+  for( int i = 1; i < argc; i++ )
+  {
+      string arg = argv[i];
+      if( arg.rfind("--lex-threads=", 0) == 0 )
+      { lexThreads = atoi(arg.c_str() + 14); }
+      else if( arg == "--lex-check" )
+      { lexCheck = true; }
+      else if( arg == "--ast-stats" )
+      { astStats = true; }
+      else if( arg == "--run" )
+      { run = true; }
+      else if( arg == "--tiered" )
+      { tiered = true; }
+      else if( arg.rfind("--tier-threshold=", 0) == 0 )
+      { tierThreshold = atoi(arg.c_str() + 17); }
+      else if( arg == "--tier-stats" )
+      { tierStats = true; }
+      else if( arg.rfind("--cache-dir=", 0) == 0 )
+      { cacheDir = arg.substr(12); }
+      else if( arg == "--cache-stats" )
+      { cacheStats = true; }
+      else if( arg.rfind("--incremental=", 0) == 0 )
+      { incrementalDir = arg.substr(14); }
+      else if( arg == "--pipeline" )
+      { pipelined = true; }
+      // taken by main
+      else if( arg.rfind("--connect", 0) == 0 )
+      {}
+      else if( arg.rfind("--jobs=", 0) == 0 )
+      {
+          split = true;
+          jobs = atoi(arg.c_str() + 7);
+      }
+      else if( arg.rfind("--emit=", 0) == 0 )
+      {
+          string kind = arg.substr(7);
+          if( kind == "ir" )
+          { emit = emitkind::ir; }
+          else if( kind == "bc" )
+          { emit = emitkind::bitcode; }
+          else if( kind == "asm" )
+          { emit = emitkind::assembly; }
+          else if( kind == "obj" )
+          { emit = emitkind::object; }
+          else if( kind == "exe" )
+          { emit = emitkind::executable; }
+          else
+          {
+              errs() << "Unknown output kind: " << kind << ", expected ir, bc, asm, obj or exe\n";
+              return 1;
+          }
+      }
+      else if( arg.rfind("-O", 0) == 0 )
+      {
+          if( !parseoptlevel(arg.substr(2), level) )
+          {
+              errs() << "Unknown optimization level: " << arg << ", expected -O0, -O1, -O2, -O3, -Os or -Oz\n";
+              return 1;
+          }
+      }
+      else if( arg.rfind("-mcpu=", 0) == 0 )
+      { CPU = arg.substr(6); }
+      else if( arg.rfind("-mattr=", 0) == 0 )
+      { Features = arg.substr(7); }
+      else if( arg.rfind("--runtime=", 0) == 0 )
+      {
+          runtime = arg.substr(10);
+          externalRuntime = true;
+      }
+      else if( arg == "--external-runtime" )
+      { externalRuntime = true; }
+      else if( arg == "--freestanding" )
+      { freestanding = true; }
+      else if( arg.rfind("--linker=", 0) == 0 )
+      { linker = arg.substr(9); }
+      else if( arg.rfind("--target=", 0) == 0 )
+      { TargetTriple = Triple::normalize(arg.substr(9)); }
+      else if( arg == "-o" && i + 1 < argc )
+      { outputFile = argv[++i]; }
+      else if( arg.rfind("-o", 0) == 0 && arg.size() > 2 )
+      { outputFile = arg.substr(2); }
+      else if( arg == "--help" )
+      {
+          outs() << usage;
+          return 0;
+      }
+      else if( arg == "-o" )
+      {
+          errs() << "-o needs the name of the output file\n";
+          return 1;
+      }
+      // a mistyped option would otherwise be taken for the program
+      else if( arg.size() > 1 && arg[0] == '-' )
+      {
+          errs() << "Unknown option: " << arg << "\n" << usage;
+          return 1;
+      }
+      else if( inputFile )
+      {
+          errs() << "Only one program can be compiled at a time: " << inputFile << " and " << arg << "\n";
+          return 1;
+      }
+      else
+      { inputFile = argv[i]; }
+  }
+  // all of them write an archive of objects
+  bool archive = split || !incrementalDir.empty() || pipelined;
+  if( outputFile.empty() )
+  {
+      SmallString<128> name(inputFile ? sys::path::filename(inputFile) : "ye");
+      sys::path::replace_extension(name, archive ? ".a" : extensionof(emit));
+      outputFile = string(name.str());
+  }
+  if( archive && ( emit != emitkind::object || outputFile == "-" || run || tiered ) )
+  {
+      errs() << "--jobs, --incremental and --pipeline only write objects to a file\n";
+      return 1;
+  }
+  if( pipelined && ( split || !incrementalDir.empty() ) )
+  {
+      errs() << "--pipeline can't be combined with --jobs or --incremental\n";
+      return 1;
+  }
+  if( emit == emitkind::executable && outputFile == "-" )
+  {
+      errs() << "--emit=exe only writes to a file\n";
+      return 1;
+  }
+  if( freestanding && ( emit != emitkind::executable || run || tiered ) )
+  {
+      errs() << "--freestanding only links executables ( --emit=exe )\n";
+      return 1;
+  }
+  // fcestart.c makes the system calls of x86-64 Linux
+  Triple triple(TargetTriple);
+  if( freestanding && ( triple.getArch() != Triple::x86_64 || !triple.isOSLinux() ) )
+  {
+      errs() << "--freestanding only links executables for x86-64 Linux\n";
+      return 1;
+  }
+
+  // only the host can run the program or describe its CPU
+  if( TargetTriple != sys::getDefaultTargetTriple() && ( run || tiered || CPU == "native" ) )
+  {
+      errs() << "--run, --tiered and -mcpu=native only work for the host's target\n";
+      return 1;
+  }
+
+  if( CPU.empty() && TargetTriple == sys::getDefaultTargetTriple() )
+  { CPU = "generic"; }
+
+  // the bitcode of the runtime is the host's, the JIT and the interpreter bind their own runtime and the parts of
+  // an archive are linked with the runtime object
+  bool inlinedRuntime = !externalRuntime && !run && !tiered && !archive && TargetTriple == sys::getDefaultTargetTriple();
+
+  // Load the whole program, from the file given as the argument or from the stdin
+  bool loaded = inputFile ? source.openfile(inputFile) : source.openstdin();
+  if( !loaded )
+  {
+      errs() << "Could not read the program: " << (inputFile ? inputFile : "stdin") << "\n";
+      return 1;
+  }
+  // Compare the token stream of every scanning kernel set the CPU supports with the scalar one
+  if( lexCheck )
+  {
+      tokenstream expected;
+      tokenize(source.begin(), source.end(), expected, 1, scalarkernels());
+      bool same = true;
+      for( auto * kernels : supportedkernels() )
+      {
+          tokenstream actual;
+          tokenize(source.begin(), source.end(), actual, 1, *kernels);
+          errs() << kernels->name << ( actual == expected ? " ok\n" : " MISMATCH\n" );
+          same = same && actual == expected;
+      }
+      return same ? 0 : 1;
+  }
+
+  // native is the host CPU with every feature it has, -mattr can still add to them or turn them off
+  if( CPU == "native" )
+  {
+      CPU = string(sys::getHostCPUName());
+      string host = hostfeatures();
+      Features = Features.empty() ? host : host + "," + Features;
+  }
+
+  // everything besides the source the output depends on, part of the keys of the cache and the incremental store
+  string options = string(extensionof(emit)) + " -O" + to_string((int) level) + " " + TargetTriple + " " + CPU + " " + Features;
+  if( !incrementalDir.empty() )
+  { options += " incremental"; }
+  else if( split )
+  { options += " split"; }
+  else if( pipelined )
+  { options += " pipeline"; }
+  // the output contains the compiled runtime, an executable also depends on the linker and the runtime object
+  if( inlinedRuntime )
+  { options += " runtime " + string(runtimebitcode()); }
+  vector< string > linkedObjects;
+  if( emit == emitkind::executable && !run && !tiered )
+  {
+      options += " exe " + linker;
+      if( !inlinedRuntime )
+      { linkedObjects.push_back(runtime); }
+      if( freestanding )
+      {
+          options += " freestanding";
+          linkedObjects.push_back(start);
+      }
+      for( const string & object : linkedObjects )
+      {
+          auto linked = MemoryBuffer::getFile(object);
+          if( !linked )
+          {
+              errs() << "Could not read the runtime: " << object << "\n";
+              return 1;
+          }
+          options += " " + string((*linked)->getBuffer());
+      }
+  }
+
+  // " CACHE " a hit writes the stored output and skips the lexer, the parser, the passes and the backend
+  unique_ptr< compilecache > cache;
+  string cacheKey;
+  if( !cacheDir.empty() && !run && !tiered && !astStats )
+  {
+      cache = make_unique<compilecache>(cacheDir);
+      cacheKey = compilecache::key(StringRef(source.begin(), source.size()), options);
+      if( auto cached = cache->lookup(cacheKey) )
+      {
+          cache->record(true);
+          if( cacheStats )
+          { cache->printstats(stderr); }
+          auto dest = openoutput(outputFile, emit);
+          if( !dest )
+          { return 1; }
+          *dest << cached->getBuffer();
+          dest->close();
+          return emit != emitkind::executable || markexecutable(outputFile) ? 0 : 1;
+      }
+  }
+
+  // everything but the interpreter compiles for a target, the stages of the pipeline already while parsing
+  if( !tiered )
+  {
+      string Error;
+      if( !initializetarget(TargetTriple, Error) )
+      {
+          errs() << "errors: " << Error << "\n";
+          return 1;
+      }
+      // the backend only warns about a CPU it doesn't know and then fails on the code it can't pick instructions for
+      auto Target = TargetRegistry::lookupTarget(TargetTriple, Error);
+      unique_ptr< MCSubtargetInfo > subtarget(Target->createMCSubtargetInfo(TargetTriple, "", ""));
+      if( !CPU.empty() && !subtarget->isCPUStringValid(CPU) )
+      {
+          errs() << "Unknown CPU: " << CPU << " for " << TargetTriple << "\n";
+          return 1;
+      }
+  }
+
+  // Lex the whole program up front, the parser walks the token stream by index
+  tokenize(source.begin(), source.end(), tokens, lexThreads);
 
   // PROGRAM
   getNextToken();
   // PROGRAM NAME
   getNextToken();
-  string programName = idname;
+  string programName(idname);
   // ;
   getNextToken();
 
-  InitializeModuleAndPassManager();
+  // the interpreter needs the trees, the functions are only optimized once they get hot
+  keepprogram = tiered;
+  // the parts are optimized on the threads that compile them, not while parsing
+  hashfunctions = !incrementalDir.empty();
+  InitializeModuleAndPassManager(level != optlevel::O0 && !tiered && !archive);
   // Create writeln and readln functions
   readlnfunc();
   writelnfunc();
 
+  if( pipelined )
+  {
+      startpipeline({ TargetTriple, CPU, Features, level });
+      finishedfunction = []( Function & f ) { pipelinefunction(f); };
+  }
+
   MainLoop();
+  if( astStats )
+  { aststats.print(stderr); }
+  // the parser goes on to the end to report every error, but a program with errors isn't written or run. Nothing
+  // has been opened for writing yet, the pipeline only writes its archive when it's finished
+  if( errorcount > 0 )
+  { return 1; }
 
-  InitializeAllTargetInfos();
-  InitializeAllTargets();
-  InitializeAllTargetMCs();
-  InitializeAllAsmParsers();
-  InitializeAllAsmPrinters();
+  if( tiered )
+  {
+      builder->CreateRet(builder->getInt32(0));
+      if( verifyModule(*module, &errs()) )
+      {
+          errs() << "Generated module is invalid\n";
+          return 1;
+      }
+      return runtiered(program, tierThreshold, tierStats);
+  }
 
-  auto TargetTriple = sys::getDefaultTargetTriple();
   module->setTargetTriple(TargetTriple);
 
   string Error;
@@ -81,49 +473,163 @@ int main (int argc, char *argv[])
       return 1;
   }
 
-  // generic cpu without any additional features
-  auto CPU = "generic";
-  auto Features = "";
-
-  Function * mainFunction = getfunction("main");
   builder->CreateRet(builder->getInt32(0));
-  verifyFunction(*mainFunction);
 
   TargetOptions opt;
-  auto RM = Optional<Reloc::Model>();
-  auto TheTargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM);
+  // the runtime indexes its buffers, their absolute addresses can't be linked into the position independent
+  // executables cc makes by default
+  auto RM = inlinedRuntime ? Optional<Reloc::Model>(Reloc::PIC_) : Optional<Reloc::Model>();
+  auto TheTargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM, None, codegenlevel(level));
 
   module->setDataLayout(TheTargetMachine->createDataLayout());
 
-  auto Filename = "ye.o";
-  error_code EC;
-  raw_fd_ostream dest(Filename, EC, sys::fs::OF_None);
+  if( inlinedRuntime && !linkruntime(*module) )
+  { return 1; }
 
-  if( EC )
+  // the vectorizer's cost model and the instruction selection take the target of each function from its attributes
+  for( Function & f : *module )
+  {
+      if( f.isDeclaration() )
+      { continue; }
+      if( !CPU.empty() )
+      { f.addFnAttr("target-cpu", CPU); }
+      if( !Features.empty() )
+      { f.addFnAttr("target-features", Features); }
+  }
+
+  // the passes can't run on broken IR
+  if( verifyModule(*module, &errs()) )
   {
-      errs() << "Could not open file: " << EC.message();
+      errs() << "Generated module is invalid\n";
       return 1;
   }
 
-  legacy::PassManager pass;
-  auto FileType = CGFT_ObjectFile;
+  if( archive )
+  {
+      targetspec target{ TargetTriple, CPU, Features, level };
+      bool emitted;
+      if( pipelined )
+      { emitted = finishpipeline(*module, outputFile); }
+      else if( !incrementalDir.empty() )
+      { emitted = emitincremental(*module, target, jobs, options, incrementalDir, outputFile, cacheStats); }
+      else
+      { emitted = emitsplit(*module, target, jobs, outputFile); }
+      if( cache )
+      {
+          auto stored = MemoryBuffer::getFile(outputFile);
+          if( emitted && stored )
+          { cache->store(cacheKey, (*stored)->getBuffer()); }
+          cache->record(false);
+          if( cacheStats )
+          { cache->printstats(stderr); }
+      }
+      return emitted ? 0 : 1;
+  }
+
+  // the functions were cleaned up one by one as they were finished, the pass over the whole
+  // module inlines across them and optimizes main, then the module is run or streamed out
+  optimizemodule(*module, TheTargetMachine, level);
 
-  if( TheTargetMachine->addPassesToEmitFile(pass, dest, nullptr, FileType) )
+  if( run )
   {
-      errs() << "TheTargetMachine can't emit a file of this type";
-      return 1;
+      int exitcode = 0;
+      return runjit(TargetTriple, CPU, Features, level, exitcode) ? exitcode : 1;
   }
 
+  // the linker writes the executable
+  bool executable = emit == emitkind::executable;
+  unique_ptr< raw_fd_ostream > dest;
+  if( !executable && !( dest = openoutput(outputFile, emit) ) )
+  { return 1; }
+  // with a cache the output is built in memory first so the same bytes can be stored, objects are written with
+  // seeks the stdout may not take when it's a pipe, the object of an executable goes to the linker from memory
+  bool buffered = cache || outputFile == "-" || executable;
+  SmallVector< char, 0 > buffer;
+  raw_svector_ostream memory(buffer);
+  raw_pwrite_stream & out = buffered ? (raw_pwrite_stream &) memory : *dest;
 
-  pass.add(createPromoteMemoryToRegisterPass());
-  pass.add(createInstructionCombiningPass());
-  pass.add(createReassociatePass());
-  pass.add(createJumpThreadingPass());
-  pass.add(createCFGSimplificationPass());
-  module->print(errs(), nullptr);
+  legacy::PassManager pass;
+
+  switch( emit )
+  {
+    case emitkind::ir:
+      pass.add(createPrintModulePass(out));
+      break;
+    case emitkind::bitcode:
+      pass.add(createBitcodeWriterPass(out));
+      break;
+    case emitkind::assembly:
+    case emitkind::object:
+    case emitkind::executable:
+      if( TheTargetMachine->addPassesToEmitFile(pass, out, nullptr, emit == emitkind::assembly ? CGFT_AssemblyFile : CGFT_ObjectFile) )
+      {
+          errs() << "TheTargetMachine can't emit a file of this type";
+          return 1;
+      }
+      break;
+  }
 
   pass.run(*module);
-  dest.flush();
+  StringRef output(buffer.data(), buffer.size());
+  // the cache keeps the executable rather than the object
+  unique_ptr< MemoryBuffer > linked;
+  if( executable )
+  {
+      if( !linkexecutable(output, linkedObjects, linker, freestanding, outputFile) )
+      { return 1; }
+      if( cache )
+      {
+          auto read = MemoryBuffer::getFile(outputFile);
+          if( read )
+          { linked = move(*read); }
+      }
+      if( linked )
+      { output = linked->getBuffer(); }
+  }
+  else if( buffered )
+  { *dest << output; }
+  if( cache )
+  {
+      if( ( !executable || linked ) && !cache->store(cacheKey, output) )
+      { errs() << "Could not write to the cache: " << cacheDir << "\n"; }
+      cache->record(false);
+      if( cacheStats )
+      { cache->printstats(stderr); }
+  }
+  if( dest )
+  { dest->flush(); }
 
   return 0;
 }
+
+int main( int argc, char * argv[] )
+{
+  // " SERVER AND CLIENT " are picked before anything of the compiler is set up
+  bool serve = false;
+  bool connect = false;
+  string socketPath = defaultsocket();
+  for( int i = 1; i < argc; i++ )
+  {
+      string arg = argv[i];
+      if( arg == "--server" )
+      { serve = true; }
+      else if( arg.rfind("--server=", 0) == 0 )
+      {
+          serve = true;
+          socketPath = arg.substr(9);
+      }
+      else if( arg == "--connect" )
+      { connect = true; }
+      else if( arg.rfind("--connect=", 0) == 0 )
+      {
+          connect = true;
+          socketPath = arg.substr(10);
+      }
+  }
+  if( serve )
+  { return runserver(socketPath, compile); }
+  int exitcode;
+  if( connect && runclient(socketPath, argc, argv, exitcode) )
+  { return exitcode; }
+  return compile(argc, argv);
+}
@@ -0,0 +1,35 @@
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+#include "Client.hpp"
+
+// " MILA-CLIENT " takes the arguments of mila and has the compile server ( --connect=<socket>, MILA_SERVER or
+// the default socket of Client.hpp ) do the compilation. Whatever the server can't do is left to the mila next to it
+int main( int argc, char * argv[] )
+{
+  string socketPath = defaultsocket();
+  for( int i = 1; i < argc; i++ )
+  {
+      string arg = argv[i];
+      if( arg.rfind("--connect=", 0) == 0 )
+      { socketPath = arg.substr(10); }
+  }
+  int exitcode;
+  if( runclient(socketPath, argc, argv, exitcode) )
+  { return exitcode; }
+
+  char self[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+  string compiler = "mila";
+  if( length > 0 )
+  {
+      string path(self, length);
+      compiler = path.substr(0, path.rfind('/') + 1) + "mila";
+  }
+  argv[0] = const_cast< char * >(compiler.c_str());
+  execvp(compiler.c_str(), argv);
+  fprintf(stderr, "Could not start the compiler: %s\n", compiler.c_str());
+  return 1;
+}